@@ -0,0 +1,591 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Apache-2.0
+# Copyright 2016-2024 Raving Bots
+
+# generates input_code.hpp and InputCode.cs from input_codes.txt
+# usage: input_codes.py <spec> [--cpp <header>] [--csharp <source>]
+
+import argparse
+import os
+import re
+import sys
+
+CATEGORY_STRIDE = 100000
+CATEGORY_REGULAR = 50000
+KINDS = ("none", "digital", "analog")
+
+FNV_OFFSET = 2166136261
+FNV_PRIME = 16777619
+MASK32 = 0xFFFFFFFF
+
+
+class SpecError(Exception):
+    pass
+
+
+class Code:
+    def __init__(self, name, value, kind, cs_name, line):
+        self.name = name
+        self.value = value
+        self.kind = kind
+        self.cs_name = cs_name
+        self.line = line
+        self.docs = []
+        self.see_also = []
+        self.category = None
+        self.slot = None
+        self.digital_slot = None
+        self.analog_slot = None
+
+
+def pascal_case(name):
+    return "".join(part[:1].upper() + part[1:] for part in name.split("_"))
+
+
+def parse_spec(path):
+    categories = []
+    codes = []
+
+    with open(path, encoding="utf-8") as spec:
+        for number, line in enumerate(spec, 1):
+            line = line.rstrip("\n")
+            where = "%s:%d" % (path, number)
+
+            if not line.strip() or line.lstrip().startswith("#"):
+                continue
+
+            if line.startswith("    "):
+                if not codes:
+                    raise SpecError("%s: documentation without a code" % where)
+
+                text = line[4:]
+                if text.startswith("@seealso "):
+                    codes[-1].see_also.append(text[len("@seealso "):].strip())
+                else:
+                    codes[-1].docs.append(text)
+                continue
+
+            fields = line.split()
+
+            if fields[0] == "category":
+                if len(fields) != 3:
+                    raise SpecError("%s: expected 'category <name> <first value>'" % where)
+
+                categories.append((fields[1], int(fields[2]), where))
+                continue
+
+            if len(fields) not in (3, 4):
+                raise SpecError("%s: expected '<name> <value> <kind> [C# name]'" % where)
+
+            name, value, kind = fields[0], int(fields[1]), fields[2]
+            cs_name = fields[3] if len(fields) == 4 else pascal_case(name)
+
+            if not re.match(r"^[a-z][a-z0-9_]*$", name):
+                raise SpecError("%s: invalid name '%s'" % (where, name))
+
+            if kind not in KINDS:
+                raise SpecError("%s: kind must be one of %s" % (where, ", ".join(KINDS)))
+
+            codes.append(Code(name, value, kind, cs_name, where))
+
+    return categories, codes
+
+
+def validate(categories, codes):
+    for index, (name, first, where) in enumerate(categories):
+        if first != index * CATEGORY_STRIDE:
+            raise SpecError("%s: category '%s' must start at %d" % (where, name, index * CATEGORY_STRIDE))
+
+    names = {}
+    cs_names = {}
+    values = {}
+
+    for code in codes:
+        for table, key in ((names, code.name), (cs_names, code.cs_name), (values, code.value)):
+            if key in table:
+                raise SpecError("%s: '%s' already defined at %s" % (code.line, key, table[key].line))
+            table[key] = code
+
+        index = code.value // CATEGORY_STRIDE
+        if code.value < 0 or index >= len(categories) or code.value % CATEGORY_STRIDE >= CATEGORY_REGULAR:
+            raise SpecError("%s: value %d is outside of every category" % (code.line, code.value))
+
+        code.category = index
+
+    ranges = []
+    slot = 0
+
+    for index, (name, first, where) in enumerate(categories):
+        members = sorted((code for code in codes if code.category == index), key=lambda c: c.value)
+
+        for offset, code in enumerate(members):
+            if code.value != first + offset:
+                raise SpecError("%s: codes of category '%s' must be contiguous from %d" % (code.line, name, first))
+
+            code.slot = slot + offset
+
+        ranges.append((name, first, len(members), slot))
+        slot += len(members)
+
+    codes.sort(key=lambda c: c.slot)
+
+    digital = [code for code in codes if code.kind == "digital"]
+    for index, code in enumerate(digital):
+        code.digital_slot = index
+
+    analog = [code for code in codes if code.kind == "analog"]
+    for index, code in enumerate(analog):
+        code.analog_slot = index
+
+    for code in codes:
+        for ref in code.see_also:
+            if ref not in cs_names:
+                raise SpecError("%s: unknown @seealso '%s'" % (code.line, ref))
+
+    return ranges, digital, analog
+
+
+# seeded FNV-1a with a final avalanche, mirrored by detail::hash_input_name
+def hash_name(name, seed):
+    value = (FNV_OFFSET ^ seed) & MASK32
+
+    for char in name.encode("utf-8"):
+        value ^= char
+        value = (value * FNV_PRIME) & MASK32
+
+    value ^= value >> 16
+    value = (value * 0x7FEB352D) & MASK32
+    value ^= value >> 15
+    value = (value * 0x846CA68B) & MASK32
+    value ^= value >> 16
+    return value
+
+
+# hash and displace: names are grouped into buckets by the base hash, then
+# every bucket (largest first) gets the first seed that moves all of its
+# names into free table entries, so lookup is two hashes and one compare
+def build_perfect_hash(names):
+    count = len(names)
+    bucket_count = max(1, (count + 3) // 4)
+
+    for base_seed in range(1, 1000):
+        buckets = [[] for _ in range(bucket_count)]
+        for index, name in enumerate(names):
+            buckets[hash_name(name, base_seed) % bucket_count].append(index)
+
+        order = sorted(range(bucket_count), key=lambda b: -len(buckets[b]))
+        seeds = [0] * bucket_count
+        table = [None] * count
+        failed = False
+
+        for bucket in order:
+            members = buckets[bucket]
+            if not members:
+                break
+
+            for seed in range(1, 0x10000):
+                entries = [hash_name(names[index], seed) % count for index in members]
+
+                if len(set(entries)) == len(entries) and all(table[e] is None for e in entries):
+                    for entry, index in zip(entries, members):
+                        table[entry] = index
+                    seeds[bucket] = seed
+                    break
+            else:
+                failed = True
+                break
+
+        if not failed:
+            # empty buckets are never hit by a valid name, any entry will do
+            return base_seed, seeds, [index if index is not None else 0 for index in table]
+
+    raise SpecError("could not build a perfect hash for %d names" % count)
+
+
+def smallest_uint(limit):
+    for bits in (8, 16, 32):
+        if limit < (1 << bits):
+            return "uint%d_t" % bits
+
+    raise SpecError("table value %d does not fit 32 bits" % limit)
+
+
+def write_table(out, type_name, name, values, per_line):
+    out.append("        constexpr %s %s[%d] = {" % (type_name, name, len(values)))
+
+    for start in range(0, len(values), per_line):
+        out.append("            " + " ".join("%s," % value for value in values[start:start + per_line]))
+
+    out.append("        };")
+    out.append("")
+
+
+def generate_cpp(categories, ranges, codes, digital, analog):
+    names = [code.name for code in codes]
+    base_seed, seeds, table = build_perfect_hash(names)
+    slot_type = smallest_uint(len(codes))
+    digital_type = smallest_uint(len(digital) + 1)
+    no_digital = (1 << int(digital_type[4:-2])) - 1
+    analog_type = smallest_uint(len(analog) + 1)
+    no_analog = (1 << int(analog_type[4:-2])) - 1
+
+    out = []
+    out.append("// SPDX-License-Identifier: Apache-2.0")
+    out.append("// Copyright 2016-2024 Raving Bots")
+    out.append("")
+    out.append("// generated by src/codegen/input_codes.py from src/codegen/input_codes.txt, do not edit")
+    out.append("")
+    out.append("#pragma once")
+    out.append("")
+    out.append("#include <cstddef>")
+    out.append("#include <cstdint>")
+    out.append("#include <functional>")
+    out.append("")
+    out.append("#include \"api_types.hpp\"")
+    out.append("")
+    out.append("namespace multi_input {")
+    out.append("    enum class input_code : int {")
+    for code in codes:
+        out.append("        %s = %d," % (code.name, code.value))
+    out.append("    };")
+    out.append("")
+    out.append("    enum class input_category : uint8_t {")
+    for index, (name, _, _) in enumerate(categories):
+        out.append("        %s = %d," % (name, index))
+    out.append("    };")
+    out.append("")
+    out.append("    // every code has a dense slot, slots follow the numeric order of codes")
+    out.append("    constexpr size_t input_code_count = %d;" % len(codes))
+    out.append("    constexpr size_t no_input_slot = static_cast<size_t>(-1);")
+    out.append("")
+    out.append("    // digital codes (buttons/keys) additionally have a slot among themselves")
+    out.append("    constexpr size_t digital_code_count = %d;" % len(digital))
+    out.append("    constexpr size_t no_digital_slot = static_cast<size_t>(-1);")
+    out.append("")
+    out.append("    // and so do analog codes (axes)")
+    out.append("    constexpr size_t analog_code_count = %d;" % len(analog))
+    out.append("    constexpr size_t no_analog_slot = static_cast<size_t>(-1);")
+    out.append("")
+    out.append("    namespace detail {")
+    out.append("        struct input_code_range {")
+    out.append("            int m_first;")
+    out.append("            size_t m_count;")
+    out.append("            size_t m_slot;")
+    out.append("        };")
+    out.append("")
+    out.append("        // indexed by value / input_category_stride")
+    out.append("        constexpr int input_category_stride = %d;" % CATEGORY_STRIDE)
+    out.append("        constexpr size_t input_category_count = %d;" % len(ranges))
+    out.append("        constexpr input_code_range input_code_ranges[input_category_count] = {")
+    for name, first, count, slot in ranges:
+        out.append("            { %d, %d, %d }, // %s" % (first, count, slot, name))
+    out.append("        };")
+    out.append("")
+    out.append("        constexpr uint8_t input_flag_digital = 1;")
+    out.append("        constexpr uint8_t input_flag_analog = 2;")
+    out.append("        constexpr uint8_t input_flag_category_shift = 4;")
+    out.append("")
+
+    write_table(out, "input_code", "input_code_values",
+                ["input_code::%s" % code.name for code in codes], 1)
+
+    flags = []
+    for code in codes:
+        value = code.category << 4
+        if code.kind == "digital":
+            value |= 1
+        elif code.kind == "analog":
+            value |= 2
+        flags.append("0x%02x" % value)
+    write_table(out, "uint8_t", "input_code_flags", flags, 12)
+
+    write_table(out, "api_string", "input_code_names",
+                ["\"%s\"" % code.name for code in codes], 1)
+
+    write_table(out, "uint8_t", "input_code_name_lengths",
+                [str(len(code.name)) for code in codes], 16)
+
+    write_table(out, digital_type, "input_code_digital_slots",
+                [str(code.digital_slot if code.digital_slot is not None else no_digital) for code in codes], 16)
+
+    write_table(out, slot_type, "digital_code_slots",
+                [str(code.slot) for code in digital], 16)
+
+    write_table(out, analog_type, "input_code_analog_slots",
+                [str(code.analog_slot if code.analog_slot is not None else no_analog) for code in codes], 16)
+
+    write_table(out, slot_type, "analog_code_slots",
+                [str(code.slot) for code in analog], 16)
+
+    out.append("        // perfect hash of the names, see build_perfect_hash in input_codes.py")
+    out.append("        constexpr uint32_t input_name_seed = %d;" % base_seed)
+    out.append("        constexpr size_t input_name_bucket_count = %d;" % len(seeds))
+    out.append("")
+
+    write_table(out, "uint16_t", "input_name_seeds", [str(seed) for seed in seeds], 12)
+    write_table(out, slot_type, "input_name_slots", [str(slot) for slot in table], 16)
+
+    out.append("        constexpr uint32_t hash_input_name(const char* name, size_t length, uint32_t seed) {")
+    out.append("            uint32_t value = %du ^ seed;" % FNV_OFFSET)
+    out.append("")
+    out.append("            for (size_t idx = 0; idx < length; ++idx) {")
+    out.append("                value ^= static_cast<uint8_t>(name[idx]);")
+    out.append("                value *= %du;" % FNV_PRIME)
+    out.append("            }")
+    out.append("")
+    out.append("            value ^= value >> 16;")
+    out.append("            value *= 0x7feb352du;")
+    out.append("            value ^= value >> 15;")
+    out.append("            value *= 0x846ca68bu;")
+    out.append("            value ^= value >> 16;")
+    out.append("            return value;")
+    out.append("        }")
+    out.append("    }")
+    out.append("")
+    out.append("    constexpr size_t to_slot(input_code code) {")
+    out.append("        auto value = static_cast<int>(code);")
+    out.append("        if (value < 0) {")
+    out.append("            return no_input_slot;")
+    out.append("        }")
+    out.append("")
+    out.append("        auto category = static_cast<size_t>(value / detail::input_category_stride);")
+    out.append("        if (category >= detail::input_category_count) {")
+    out.append("            return no_input_slot;")
+    out.append("        }")
+    out.append("")
+    out.append("        auto offset = static_cast<size_t>(value - detail::input_code_ranges[category].m_first);")
+    out.append("        if (offset >= detail::input_code_ranges[category].m_count) {")
+    out.append("            return no_input_slot;")
+    out.append("        }")
+    out.append("")
+    out.append("        return detail::input_code_ranges[category].m_slot + offset;")
+    out.append("    }")
+    out.append("")
+    out.append("    constexpr input_code from_slot(size_t slot) {")
+    out.append("        return slot < input_code_count ? detail::input_code_values[slot] : input_code::none;")
+    out.append("    }")
+    out.append("")
+    out.append("    constexpr bool is_known(input_code code) {")
+    out.append("        return to_slot(code) != no_input_slot;")
+    out.append("    }")
+    out.append("")
+    out.append("    constexpr uint8_t get_flags(input_code code) {")
+    out.append("        return is_known(code) ? detail::input_code_flags[to_slot(code)] : 0;")
+    out.append("    }")
+    out.append("")
+    out.append("    constexpr input_category get_category(input_code code) {")
+    out.append("        return static_cast<input_category>(get_flags(code) >> detail::input_flag_category_shift);")
+    out.append("    }")
+    out.append("")
+    out.append("    constexpr bool is_digital(input_code code) {")
+    out.append("        return (get_flags(code) & detail::input_flag_digital) != 0;")
+    out.append("    }")
+    out.append("")
+    out.append("    constexpr bool is_analog(input_code code) {")
+    out.append("        return (get_flags(code) & detail::input_flag_analog) != 0;")
+    out.append("    }")
+    out.append("")
+    out.append("    constexpr size_t to_digital_slot(input_code code) {")
+    out.append("        return is_digital(code) ? detail::input_code_digital_slots[to_slot(code)] : no_digital_slot;")
+    out.append("    }")
+    out.append("")
+    out.append("    constexpr input_code from_digital_slot(size_t slot) {")
+    out.append("        return slot < digital_code_count ? from_slot(detail::digital_code_slots[slot]) : input_code::none;")
+    out.append("    }")
+    out.append("")
+    out.append("    constexpr size_t to_analog_slot(input_code code) {")
+    out.append("        return is_analog(code) ? detail::input_code_analog_slots[to_slot(code)] : no_analog_slot;")
+    out.append("    }")
+    out.append("")
+    out.append("    constexpr input_code from_analog_slot(size_t slot) {")
+    out.append("        return slot < analog_code_count ? from_slot(detail::analog_code_slots[slot]) : input_code::none;")
+    out.append("    }")
+    out.append("")
+    out.append("    constexpr api_string to_string(input_code code) {")
+    out.append("        return is_known(code) ? detail::input_code_names[to_slot(code)] : \"unknown\";")
+    out.append("    }")
+    out.append("")
+    out.append("    // exact, case-sensitive match of the enumerator name, e.g. \"pad_left_stick_x\"")
+    out.append("    constexpr bool parse_input_code(const char* name, size_t length, input_code& code) {")
+    out.append("        auto bucket = detail::hash_input_name(name, length, detail::input_name_seed) % detail::input_name_bucket_count;")
+    out.append("        auto entry = detail::hash_input_name(name, length, detail::input_name_seeds[bucket]) % input_code_count;")
+    out.append("        auto slot = static_cast<size_t>(detail::input_name_slots[entry]);")
+    out.append("")
+    out.append("        if (detail::input_code_name_lengths[slot] != length) {")
+    out.append("            return false;")
+    out.append("        }")
+    out.append("")
+    out.append("        for (size_t idx = 0; idx < length; ++idx) {")
+    out.append("            if (detail::input_code_names[slot][idx] != name[idx]) {")
+    out.append("                return false;")
+    out.append("            }")
+    out.append("        }")
+    out.append("")
+    out.append("        code = detail::input_code_values[slot];")
+    out.append("        return true;")
+    out.append("    }")
+    out.append("}")
+    out.append("")
+    out.append("namespace std {")
+    out.append("    template <>")
+    out.append("    struct hash<multi_input::input_code> {")
+    out.append("        using argument_type = multi_input::input_code;")
+    out.append("        using result_type = std::hash<int>::result_type;")
+    out.append("")
+    out.append("        result_type operator()(const argument_type& s) const {")
+    out.append("            return std::hash<int>{}(static_cast<int>(s));")
+    out.append("        }")
+    out.append("    };")
+    out.append("}")
+    out.append("")
+    return "\n".join(out)
+
+
+CS_HEADER = """\
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+using System.Diagnostics.CodeAnalysis;
+
+namespace RavingBots.MultiInput
+{
+	/// <summary>
+	///     Platform- and device-independent virtual axis codes.
+	/// </summary>
+	/// <remarks>
+	///     <para>
+	///         This enumeration is guaranteed to be forward- and backward-compatible,
+	///         and so can be safely serialized. <see cref="InputCodeExt" /> contains few utility
+	///         extension methods related to <c>InputCode</c>.
+	///     </para>
+	///     <para>
+	///         Not all codes present here will actually
+	///         be reported - it highly depends on what the OS and the actual device supports. You should
+	///         keep that in mind when determining default controls for your game.
+	///     </para>
+	///     <note type="important">
+	///         Keyboard codes are based on US International layout. There are several so-called OEM keys which might have
+	///         different
+	///         purpose on some layouts (those will be marked in remarks). We currently don't process or expose keyboard layout
+	///         information,
+	///         only report the codes as-is, based on what we get from the OS.
+	///         This might affect accuracy of UI when presenting the keys based on the input codes in localized settings.
+	///     </note>
+	///     <para>
+	///         There are three enumerator value ranges:
+	///         <list type="bullet">
+	///             <item>
+	///                 All keyboard codes have values between <see cref="InputCodeExt.KeyboardRangeStart" /> and
+	///                 <see cref="InputCodeExt.KeyboardRangeEnd" /> (inclusive).
+	///             </item>
+	///             <item>
+	///                 All mouse codes have values between <see cref="InputCodeExt.MouseRangeStart" /> and
+	///                 <see cref="InputCodeExt.MouseRangeStart" /> (inclusive).
+	///             </item>
+	///             <item>
+	///                 All gamepad codes have values between <see cref="InputCodeExt.PadRangeStart" /> and
+	///                 <see cref="InputCodeExt.PadRangeStart" /> (inclusive).
+	///             </item>
+	///         </list>
+	///     </para>
+	///     <para>
+	///         Additionally, three subranges are available for your use, if you need to store
+	///         custom codes:
+	///     </para>
+	///     <list type="bullet">
+	///         <item>
+	///             Custom keyboard codes should have values between <see cref="InputCodeExt.KeyboardCustomRangeStart" /> and
+	///             <see cref="InputCodeExt.KeyboardRangeEnd" /> (inclusive).
+	///         </item>
+	///         <item>
+	///             Custom mouse codes have should values between <see cref="InputCodeExt.MouseCustomRangeStart" /> and
+	///             <see cref="InputCodeExt.MouseRangeStart" /> (inclusive).
+	///         </item>
+	///         <item>
+	///             Custom gamepad codes have should values between <see cref="InputCodeExt.PadCustomRangeStart" /> and
+	///             <see cref="InputCodeExt.PadRangeStart" /> (inclusive).
+	///         </item>
+	///     </list>
+	///     <para>
+	///         Axes representing digital buttons always report 0 or 1 value. Other axes will report scalar floating point
+	///         values.
+	///         The range of analog axis values depends on the axis (for example <see cref="MouseX" /> range is unbounded, and
+	///         <see cref="PadLeftStickX" /> range is <c>[-1, 1]</c>) - see the description of the enumerator for details.
+	///         Range notation has been used throughout this document as a shorthand:
+	///     </para>
+	///     <list type="bullet">
+	///         <item><c>[x, y]</c> means "from x (inclusive) to y (inclusive)"</item>
+	///         <item><c>[x, y)</c> means "from x (inclusive) to y (exclusive)"</item>
+	///         <item><c>(x, y]</c> means "from x (exclusive) to y (inclusive)"</item>
+	///         <item><c>(x, y)</c> means "from x (exclusive) to y (exclusive)"</item>
+	///     </list>
+	/// </remarks>
+	/// <seealso cref="InputCodeExt" />
+	[SuppressMessage("ReSharper", "UnusedMember.Global")]
+	public enum InputCode
+	{
+"""
+
+
+def generate_csharp(codes, header):
+    out = [header.rstrip("\n")]
+    out.append("\t\t// generated by src/codegen/input_codes.py from src/codegen/input_codes.txt, do not edit")
+    out.append("\t\t// see input_codes.txt for the rules on adding codes")
+
+    for index, code in enumerate(codes):
+        out.append("")
+        out.append("\t\t/// <summary>")
+        for doc in code.docs:
+            out.append("\t\t///     " + doc)
+        out.append("\t\t/// </summary>")
+        for ref in code.see_also:
+            out.append("\t\t/// <seealso cref=\"%s\" />" % ref)
+        out.append("\t\t%s = %d%s" % (code.cs_name, code.value, "," if index + 1 < len(codes) else ""))
+
+    out.append("\t}")
+    out.append("}")
+    out.append("")
+    return "\n".join(out).replace("\n", "\r\n")
+
+
+def write_if_changed(path, text):
+    data = text.encode("utf-8")
+
+    if os.path.exists(path):
+        with open(path, "rb") as existing:
+            if existing.read() == data:
+                return
+
+    directory = os.path.dirname(path)
+    if directory:
+        os.makedirs(directory, exist_ok=True)
+
+    with open(path, "wb") as output:
+        output.write(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generates input code tables.")
+    parser.add_argument("spec")
+    parser.add_argument("--cpp", help="path of the generated C++ header")
+    parser.add_argument("--csharp", help="path of the generated C# enumeration")
+    args = parser.parse_args()
+
+    try:
+        categories, codes = parse_spec(args.spec)
+        ranges, digital, analog = validate(categories, codes)
+
+        if args.cpp:
+            write_if_changed(args.cpp, generate_cpp(categories, ranges, codes, digital, analog))
+
+        if args.csharp:
+            write_if_changed(args.csharp, generate_csharp(codes, CS_HEADER))
+    except SpecError as error:
+        print("input_codes.py: error: %s" % error, file=sys.stderr)
+        return 1
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#include <algorithm>
+#include <cmath>
+
+#include "actions.hpp"
+#include "context.hpp"
+#include "device.hpp"
+
+namespace multi_input {
+    action_table::action_table() :
+        m_player_count(0), m_action_count(0), m_bindings()
+    {
+    }
+
+    void action_table::set_bindings(size_t player_count, size_t action_count, const action_binding* bindings, size_t count) {
+        m_player_count = player_count;
+        m_action_count = action_count;
+
+        m_bindings.clear();
+        m_bindings.reserve(count);
+
+        for (size_t idx = 0; idx < count; ++idx) {
+            m_bindings.emplace_back(binding{bindings[idx], {}});
+        }
+    }
+
+    void action_table::remove_device(device_id id) {
+        for (auto&& b : m_bindings) {
+            auto&& down = b.m_down;
+            down.erase(std::remove(down.begin(), down.end(), id), down.end());
+        }
+    }
+
+    void action_table::evaluate(context& ctx, api_float* values) {
+        std::fill_n(values, get_value_count(), 0.0f);
+
+        for (auto&& b : m_bindings) {
+            auto&& params = b.m_binding;
+            auto best = 0.0f;
+
+            auto visit = [&](device& dev) {
+                auto value = evaluate_device(b, dev);
+
+                if (std::fabs(value) > std::fabs(best)) {
+                    best = value;
+                }
+            };
+
+            if (params.m_device != 0) {
+                auto dev = ctx.get_device(params.m_device);
+
+                if (dev != nullptr) {
+                    visit(*dev);
+                }
+            } else {
+                ctx.for_each_device(visit);
+            }
+
+            auto&& out = values[static_cast<size_t>(params.m_player) * m_action_count + static_cast<size_t>(params.m_action)];
+            if (std::fabs(best) > std::fabs(out)) {
+                out = best;
+            }
+        }
+    }
+
+    float action_table::evaluate_device(action_table::binding& b, device& dev) {
+        auto&& params = b.m_binding;
+        auto axis = dev.get_axis(params.m_code);
+
+        if (axis == nullptr) {
+            return 0;
+        }
+
+        auto value = axis->get();
+
+        for (auto&& modifier : params.m_modifiers) {
+            if (modifier == input_code::none) {
+                continue;
+            }
+
+            auto modifier_axis = dev.get_axis(modifier);
+            if (modifier_axis == nullptr || modifier_axis->get() == 0) {
+                value = 0;
+                break;
+            }
+        }
+
+        if (params.m_press_threshold > 0) {
+            auto&& down = b.m_down;
+            auto it = std::find(down.begin(), down.end(), dev.get_id());
+            auto was_down = it != down.end();
+            auto magnitude = std::fabs(value);
+            auto is_down = was_down ? magnitude > params.m_release_threshold : magnitude >= params.m_press_threshold;
+
+            if (is_down && !was_down) {
+                down.emplace_back(dev.get_id());
+            } else if (!is_down && was_down) {
+                down.erase(it);
+            }
+
+            value = is_down ? 1.0f : 0.0f;
+        }
+
+        return value * params.m_scale;
+    }
+}
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include <vector>
+
+#include "utils.hpp"
+#include "api_types.hpp"
+#include "input_code.hpp"
+
+namespace multi_input {
+    struct context;
+    struct device;
+
+    constexpr size_t max_binding_modifiers = 2;
+
+    // maps one input code to an action of a player
+    // m_device of 0 matches every device that has the code
+    // a non-zero m_press_threshold turns the value into a button (0 or 1)
+    // that stays down while the magnitude is above m_release_threshold, so
+    // with a release threshold of 0 it releases when the value returns to 0
+    struct action_binding {
+        api_int m_player;
+        api_int m_action;
+        device_id m_device;
+        input_code m_code;
+        input_code m_modifiers[max_binding_modifiers];
+        api_float m_press_threshold;
+        api_float m_release_threshold;
+        api_float m_scale;
+    };
+
+    static_assert(std::is_pod<action_binding>::value, "action_binding must be a POD");
+
+    // resolves all bindings in one pass, the output is a dense
+    // player-major array of player_count * action_count values
+    // if several bindings drive the same action the largest magnitude wins
+    struct action_table {
+        RB_MOVEABLE(action_table);
+
+        action_table();
+
+        // bindings must be validated by the caller
+        void set_bindings(size_t, size_t, const action_binding*, size_t);
+        void remove_device(device_id);
+
+        size_t get_value_count() const {
+            return m_player_count * m_action_count;
+        }
+
+        void evaluate(context&, api_float*);
+    private:
+        struct binding {
+            action_binding m_binding;
+            // devices on which the thresholded button is currently down
+            std::vector<device_id> m_down;
+        };
+
+        float evaluate_device(binding&, device&);
+
+        size_t m_player_count;
+        size_t m_action_count;
+        std::vector<binding> m_bindings;
+    };
+}
@@ -9,6 +9,12 @@
 #include "context.hpp"
 #include "enumeration.hpp"
 #include "virtual_axis.hpp"
+#include "haptics.hpp"
+#include "recognizer.hpp"
+#include "actions.hpp"
+#include "latency.hpp"
+#include "frame_codec.hpp"
+#include "virtual_device.hpp"
 #include "log_level.hpp"
 #include "utils.hpp"
 
@@ -154,6 +160,99 @@ namespace multi_input {
         }
     }
 
+    RB_API api_bool RB_APICALL_POST rb_minput_set_allocator(options* opts, alloc_callback alloc, free_callback free, user_data data) {
+        RB_TRACE_ENTER();
+
+        if (opts == nullptr) {
+            RB_TRACE("nullptr opts");
+            return 0;
+        }
+
+        if ((alloc == nullptr) != (free == nullptr)) {
+            RB_TRACE("mismatched callbacks");
+            return 0;
+        }
+
+        try {
+            if (alloc == nullptr) {
+                RB_TRACE("setting default allocator");
+                opts->set_allocator(default_allocator());
+            } else {
+                RB_TRACE("setting custom allocator");
+                opts->set_allocator(allocator{alloc, free, data});
+            }
+            return 1;
+        } catch (...) {
+            RB_TRACE("exception");
+            return 0;
+        }
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_set_sources(options* opts, api_int sources) {
+        RB_TRACE_ENTER();
+
+        if (opts == nullptr) {
+            RB_TRACE("nullptr opts");
+            return 0;
+        }
+
+        RB_TRACE("setting source mask");
+        opts->set_sources(sources);
+        return 1;
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_set_device_classes(options* opts, api_int classes) {
+        RB_TRACE_ENTER();
+
+        if (opts == nullptr) {
+            RB_TRACE("nullptr opts");
+            return 0;
+        }
+
+        RB_TRACE("setting device class mask");
+        opts->set_device_classes(classes);
+        return 1;
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_set_lazy_sources(options* opts, api_bool lazy) {
+        RB_TRACE_ENTER();
+
+        if (opts == nullptr) {
+            RB_TRACE("nullptr opts");
+            return 0;
+        }
+
+        RB_TRACE("setting lazy sources");
+        opts->set_lazy_sources(lazy != 0);
+        return 1;
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_set_shared_sources(options* opts, api_bool shared) {
+        RB_TRACE_ENTER();
+
+        if (opts == nullptr) {
+            RB_TRACE("nullptr opts");
+            return 0;
+        }
+
+        RB_TRACE("setting shared sources");
+        opts->set_shared_sources(shared != 0);
+        return 1;
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_set_drain_budget(options* opts, api_int max_events, api_int max_microseconds) {
+        RB_TRACE_ENTER();
+
+        if (opts == nullptr) {
+            RB_TRACE("nullptr opts");
+            return 0;
+        }
+
+        RB_TRACE("setting drain budget");
+        opts->set_drain_budget(max_events, max_microseconds);
+        return 1;
+    }
+
     RB_API api_bool RB_APICALL_POST rb_minput_destroy_options(options* opts) {
         RB_TRACE_ENTER();
 
@@ -241,6 +340,16 @@ namespace multi_input {
         });
     }
 
+    RB_API api_bool RB_APICALL_POST rb_minput_open_sources(context* ctx, api_int classes) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            RB_TRACE("opening sources");
+            ctx->open_sources(classes);
+            return 1;
+        });
+    }
+
     // events
     RB_API api_bool RB_APICALL_POST rb_minput_drain_events(context* ctx) {
         RB_TRACE_ENTER();
@@ -252,13 +361,75 @@ namespace multi_input {
         });
     }
 
+    RB_API api_bool RB_APICALL_POST rb_minput_drain_devices(context* ctx, const device_id* ids, size_t count) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            if (ids == nullptr && count > 0) {
+                RB_TRACE("nullptr ids");
+                ctx->log_error(u8"drain_devices: ids must not be NULL");
+                return 0;
+            }
+
+            RB_TRACE("draining selected devices");
+            ctx->drain_devices(ids, count);
+            return 1;
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_drain_slices(context* ctx, event_time start, event_time end, api_int count) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            if (count <= 0) {
+                RB_TRACE("invalid count");
+                ctx->log_error(u8"drain_slices: slice count must be positive, got %1%", count);
+                return 0;
+            }
+
+            if (start != 0 && end != 0 && end < start) {
+                RB_TRACE("invalid range");
+                ctx->log_error(u8"drain_slices: end %1% is before start %2%", end, start);
+                return 0;
+            }
+
+            RB_TRACE("draining events into slices");
+            ctx->drain_slices(start, end, static_cast<size_t>(count));
+            return 1;
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_commit_slice(context* ctx) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            RB_TRACE("committing slice");
+            return ctx->commit_slice() ? 1 : 0;
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_wait_events(context* ctx, api_int timeout) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            // negative timeouts (milliseconds) wait until something arrives
+            auto duration = timeout < 0 ? wait_forever : static_cast<event_time>(timeout) * 1000;
+
+            RB_TRACE("waiting for sources");
+            return ctx->wait_events(duration) ? 1 : 0;
+        });
+    }
+
     // device list
     RB_API enumeration* RB_APICALL_POST rb_minput_get_devices(context* ctx) {
         RB_TRACE_ENTER();
 
         return with_guard<enumeration*>(RB_GUARD_ARGS [&](){
+            RB_TRACE("opening lazy sources");
+            ctx->open_sources(all_device_classes);
+
             RB_TRACE("creating enumeration");
-            return new enumeration(ctx);
+            return new (ctx) enumeration(ctx);
         });
     }
 
@@ -401,6 +572,80 @@ namespace multi_input {
         });
     }
 
+    // haptics calls may come from any thread, so they log through the
+    // deferred queue and never reach the device map
+    RB_API api_bool RB_APICALL_POST rb_minput_play_haptics(context* ctx, device_id id, const haptics_keyframe* keyframes, size_t count) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            if (keyframes == nullptr || count == 0) {
+                RB_TRACE("no keyframes");
+                ctx->log_deferred(log_level::error, u8"play_haptics: keyframes must not be NULL or empty");
+                return 0;
+            }
+
+            if (count > max_haptics_keyframes) {
+                RB_TRACE("too many keyframes");
+                ctx->log_deferred(log_level::error, u8"play_haptics: at most %1% keyframes are supported (got %2%)", max_haptics_keyframes, count);
+                return 0;
+            }
+
+            auto last_time = 0;
+            for (size_t idx = 0; idx < count; ++idx) {
+                auto&& keyframe = keyframes[idx];
+
+                if (keyframe.m_time < last_time) {
+                    RB_TRACE("keyframe time out of range");
+                    ctx->log_deferred(log_level::error, u8"play_haptics: keyframe %1% time must be non-negative and not less than the previous one (got %2%)", idx, keyframe.m_time);
+                    return 0;
+                }
+
+                // written so NaN fails too, the worker converts them to integer strengths
+                if (!(keyframe.m_left >= 0.f && keyframe.m_left <= 1.f) || !(keyframe.m_right >= 0.f && keyframe.m_right <= 1.f)) {
+                    RB_TRACE("keyframe strength out of range");
+                    ctx->log_deferred(log_level::error, u8"play_haptics: keyframe %1% motor strength must be between 0 and 1 (got %2%/%3%)", idx, keyframe.m_left, keyframe.m_right);
+                    return 0;
+                }
+
+                last_time = keyframe.m_time;
+            }
+
+            try {
+                RB_TRACE("submitting haptics timeline");
+                if (!ctx->play_haptics(id, haptics_timeline(keyframes, keyframes + count))) {
+                    RB_TRACE("device not found");
+                    ctx->log_deferred(log_level::warning, u8"play_haptics: device %1% not found or has no haptics", id);
+                    return 0;
+                }
+            } catch (...) {
+                ctx->log_deferred_exception();
+                return 0;
+            }
+
+            return 1;
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_stop_haptics(context* ctx, device_id id) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            try {
+                RB_TRACE("submitting empty haptics timeline");
+                if (!ctx->play_haptics(id, haptics_timeline{})) {
+                    RB_TRACE("device not found");
+                    ctx->log_deferred(log_level::warning, u8"stop_haptics: device %1% not found or has no haptics", id);
+                    return 0;
+                }
+            } catch (...) {
+                ctx->log_deferred_exception();
+                return 0;
+            }
+
+            return 1;
+        });
+    }
+
     RB_API api_bool RB_APICALL_POST rb_minput_reset_device(context* ctx, device_id id) {
         RB_TRACE_ENTER();
 
@@ -464,12 +709,13 @@ namespace multi_input {
             }
 
             RB_TRACE("copying supported axes");
-            auto axes = device->get_axis_codes();
+            size_t count = 0;
 
-            buffer_size = std::min(buffer_size, axes.size());
+            device->any_axis_code([&](input_code code) {
+                buffer[count++] = code;
+                return count == buffer_size;
+            });
 
-            auto it = std::begin(axes);
-            std::copy(it, it + buffer_size, buffer);
             return 1;
         });
     }
@@ -603,6 +849,38 @@ namespace multi_input {
         });
     }
 
+    RB_API api_bool RB_APICALL_POST rb_minput_get_changed_time(context* ctx, device_id id, input_code code, event_time* time) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            if (time == nullptr) {
+                RB_TRACE("nullptr time");
+                ctx->log_error(u8"get_changed_time: time must not be NULL");
+                return 0;
+            }
+
+            RB_TRACE("grabbing device");
+            auto device = ctx->get_device(id);
+
+            if (device == nullptr) {
+                RB_TRACE("device not found");
+                ctx->log_warning(u8"get_changed_time: device %1% not found", id);
+                return 0;
+            }
+
+            RB_TRACE("grabbing axis");
+            auto axis = device->get_axis(code);
+
+            if (axis == nullptr) {
+                RB_TRACE("axis not found");
+                return 0;
+            }
+
+            *time = axis->get_changed();
+            return 1;
+        });
+    }
+
     RB_API api_bool RB_APICALL_POST rb_minput_set_value(context* ctx, device_id id, input_code code, float value) {
         RB_TRACE_ENTER();
 
@@ -696,14 +974,688 @@ namespace multi_input {
             if (in_codes == nullptr || in_size == 0) {
                 RB_TRACE("not using in_codes");
                 begin = end = nullptr;
+                ctx->open_sources(all_device_classes);
             } else {
                 RB_TRACE("using in_codes");
                 begin = in_codes;
                 end   = in_codes + in_size;
+                ctx->open_sources_for(in_codes, in_size);
             }
 
             RB_TRACE("calling find_first");
             return ctx->find_first(cb, begin, end, out_id, out_code);
         });
     }
+
+    // digital channels
+    static size_t copy_digital_codes(const digital_bits& bits, input_code* buffer, size_t buffer_size) {
+        size_t count = 0;
+
+        digital_channels::for_each(bits, [&](size_t slot) {
+            if (buffer != nullptr && count < buffer_size) {
+                buffer[count] = from_digital_slot(slot);
+            }
+
+            ++count;
+        });
+
+        return count;
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_any_held(context* ctx, device_id id) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            RB_TRACE("grabbing device");
+            auto device = ctx->get_device(id);
+
+            if (device == nullptr) {
+                RB_TRACE("device not found");
+                ctx->log_warning(u8"any_held: device %1% not found", id);
+                return 0;
+            }
+
+            return device->get_digital().any_held() ? 1 : 0;
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_all_held(context* ctx, device_id id, const input_code* codes, size_t count) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            if (codes == nullptr || count == 0) {
+                RB_TRACE("no codes");
+                ctx->log_error(u8"all_held: codes must not be NULL or empty");
+                return 0;
+            }
+
+            RB_TRACE("grabbing device");
+            auto device = ctx->get_device(id);
+
+            if (device == nullptr) {
+                RB_TRACE("device not found");
+                ctx->log_warning(u8"all_held: device %1% not found", id);
+                return 0;
+            }
+
+            RB_TRACE("building chord mask");
+            digital_bits mask{};
+            for (size_t idx = 0; idx < count; ++idx) {
+                auto slot = to_digital_slot(codes[idx]);
+
+                if (slot == no_digital_slot) {
+                    RB_TRACE("non-digital code");
+                    ctx->log_error(u8"all_held: code %1% is not a digital code", static_cast<int>(codes[idx]));
+                    return 0;
+                }
+
+                digital_channels::assign(mask, slot, true);
+            }
+
+            return device->get_digital().all_held(mask) ? 1 : 0;
+        });
+    }
+
+    RB_API size_t RB_APICALL_POST rb_minput_get_pressed(context* ctx, device_id id, input_code* buffer, size_t buffer_size) {
+        RB_TRACE_ENTER();
+
+        return with_guard<size_t>(RB_GUARD_ARGS [&](){
+            RB_TRACE("grabbing device");
+            auto device = ctx->get_device(id);
+
+            if (device == nullptr) {
+                RB_TRACE("device not found");
+                ctx->log_warning(u8"get_pressed: device %1% not found", id);
+                return size_t{};
+            }
+
+            RB_TRACE("copying pressed codes");
+            return copy_digital_codes(device->get_digital().pressed(), buffer, buffer_size);
+        });
+    }
+
+    RB_API size_t RB_APICALL_POST rb_minput_get_released(context* ctx, device_id id, input_code* buffer, size_t buffer_size) {
+        RB_TRACE_ENTER();
+
+        return with_guard<size_t>(RB_GUARD_ARGS [&](){
+            RB_TRACE("grabbing device");
+            auto device = ctx->get_device(id);
+
+            if (device == nullptr) {
+                RB_TRACE("device not found");
+                ctx->log_warning(u8"get_released: device %1% not found", id);
+                return size_t{};
+            }
+
+            RB_TRACE("copying released codes");
+            return copy_digital_codes(device->get_digital().released(), buffer, buffer_size);
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_get_transitions(context* ctx, device_id id, const input_code* codes, size_t count, api_int* presses, api_int* releases) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            if (codes == nullptr && count > 0) {
+                RB_TRACE("no codes");
+                ctx->log_error(u8"get_transitions: codes must not be NULL");
+                return 0;
+            }
+
+            RB_TRACE("grabbing device");
+            auto device = ctx->get_device(id);
+
+            if (device == nullptr) {
+                RB_TRACE("device not found");
+                ctx->log_warning(u8"get_transitions: device %1% not found", id);
+                return 0;
+            }
+
+            RB_TRACE("copying transition counts");
+            for (size_t idx = 0; idx < count; ++idx) {
+                auto axis = device->get_axis(codes[idx]);
+
+                if (presses != nullptr) {
+                    presses[idx] = axis == nullptr ? 0 : axis->get_presses();
+                }
+
+                if (releases != nullptr) {
+                    releases[idx] = axis == nullptr ? 0 : axis->get_releases();
+                }
+            }
+
+            return 1;
+        });
+    }
+
+    // patterns
+    RB_API api_bool RB_APICALL_POST rb_minput_add_pattern(context* ctx, pattern_kind kind, const pattern_step* steps, size_t count, api_int* out_id) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            if (kind != pattern_kind::sequence && kind != pattern_kind::chord) {
+                RB_TRACE("invalid kind");
+                ctx->log_error(u8"add_pattern: invalid pattern kind %1%", static_cast<int>(kind));
+                return 0;
+            }
+
+            if (steps == nullptr || count == 0) {
+                RB_TRACE("no steps");
+                ctx->log_error(u8"add_pattern: steps must not be NULL or empty");
+                return 0;
+            }
+
+            if (count > max_pattern_steps) {
+                RB_TRACE("too many steps");
+                ctx->log_error(u8"add_pattern: at most %1% steps are supported (got %2%)", max_pattern_steps, count);
+                return 0;
+            }
+
+            if (out_id == nullptr) {
+                RB_TRACE("no out_id");
+                ctx->log_error(u8"add_pattern: out_id must not be NULL");
+                return 0;
+            }
+
+            for (size_t idx = 0; idx < count; ++idx) {
+                auto&& step = steps[idx];
+
+                if (!is_digital(step.m_code)) {
+                    RB_TRACE("non-digital code");
+                    ctx->log_error(u8"add_pattern: step %1% code %2% is not a digital code", idx, static_cast<int>(step.m_code));
+                    return 0;
+                }
+
+                if (step.m_window < 0) {
+                    RB_TRACE("window out of range");
+                    ctx->log_error(u8"add_pattern: step %1% window must be non-negative (got %2%)", idx, step.m_window);
+                    return 0;
+                }
+            }
+
+            RB_TRACE("opening lazy sources");
+            for (size_t idx = 0; idx < count; ++idx) {
+                ctx->open_sources_for(&steps[idx].m_code, 1);
+            }
+
+            RB_TRACE("compiling pattern");
+            *out_id = ctx->get_recognizer().add_pattern(kind, steps, count);
+            return 1;
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_remove_pattern(context* ctx, api_int id) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            if (!ctx->get_recognizer().remove_pattern(id)) {
+                RB_TRACE("pattern not found");
+                ctx->log_warning(u8"remove_pattern: pattern %1% not found", id);
+                return 0;
+            }
+
+            return 1;
+        });
+    }
+
+    RB_API size_t RB_APICALL_POST rb_minput_get_matches(context* ctx, pattern_match* buffer, size_t buffer_size) {
+        RB_TRACE_ENTER();
+
+        return with_guard<size_t>(RB_GUARD_ARGS [&](){
+            auto&& matches = ctx->get_recognizer().get_matches();
+
+            if (buffer != nullptr) {
+                RB_TRACE("copying matches");
+                std::copy_n(matches.begin(), std::min(buffer_size, matches.size()), buffer);
+            }
+
+            return matches.size();
+        });
+    }
+
+    // actions
+    RB_API api_bool RB_APICALL_POST rb_minput_set_bindings(context* ctx, size_t player_count, size_t action_count, const action_binding* bindings, size_t count) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            if (bindings == nullptr && count > 0) {
+                RB_TRACE("no bindings");
+                ctx->log_error(u8"set_bindings: bindings must not be NULL");
+                return 0;
+            }
+
+            for (size_t idx = 0; idx < count; ++idx) {
+                auto&& binding = bindings[idx];
+
+                if (binding.m_player < 0 || static_cast<size_t>(binding.m_player) >= player_count) {
+                    RB_TRACE("player out of range");
+                    ctx->log_error(u8"set_bindings: binding %1% player must be between 0 and %2% (got %3%)", idx, player_count, binding.m_player);
+                    return 0;
+                }
+
+                if (binding.m_action < 0 || static_cast<size_t>(binding.m_action) >= action_count) {
+                    RB_TRACE("action out of range");
+                    ctx->log_error(u8"set_bindings: binding %1% action must be between 0 and %2% (got %3%)", idx, action_count, binding.m_action);
+                    return 0;
+                }
+
+                if (binding.m_code == input_code::none) {
+                    RB_TRACE("no code");
+                    ctx->log_error(u8"set_bindings: binding %1% must have a code", idx);
+                    return 0;
+                }
+
+                if (binding.m_press_threshold < 0 || binding.m_release_threshold < 0 || binding.m_release_threshold > binding.m_press_threshold) {
+                    RB_TRACE("thresholds out of range");
+                    ctx->log_error(u8"set_bindings: binding %1% thresholds must satisfy 0 <= release <= press (got %2%/%3%)", idx, binding.m_release_threshold, binding.m_press_threshold);
+                    return 0;
+                }
+            }
+
+            RB_TRACE("opening lazy sources");
+            for (size_t idx = 0; idx < count; ++idx) {
+                ctx->open_sources_for(&bindings[idx].m_code, 1);
+                ctx->open_sources_for(bindings[idx].m_modifiers, max_binding_modifiers);
+            }
+
+            RB_TRACE("replacing bindings");
+            ctx->get_actions().set_bindings(player_count, action_count, bindings, count);
+            return 1;
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_evaluate_actions(context* ctx, api_float* values, size_t size) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            auto&& actions = ctx->get_actions();
+
+            if (values == nullptr || size < actions.get_value_count()) {
+                RB_TRACE("buffer too small");
+                ctx->log_error(u8"evaluate_actions: values must hold at least %1% floats (got %2%)", actions.get_value_count(), size);
+                return 0;
+            }
+
+            RB_TRACE("evaluating actions");
+            actions.evaluate(*ctx, values);
+            return 1;
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_get_latency(context* ctx, device_id id, latency_stats* stats) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            if (stats == nullptr) {
+                RB_TRACE("nullptr stats");
+                ctx->log_error(u8"get_latency: stats must not be NULL");
+                return 0;
+            }
+
+            RB_TRACE("grabbing device");
+            auto device = ctx->get_device(id);
+
+            if (device == nullptr) {
+                RB_TRACE("device not found");
+                ctx->log_warning(u8"get_latency: device %1% not found", id);
+                return 0;
+            }
+
+            device->get_latency().get_stats(*stats);
+            return 1;
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_reset_latency(context* ctx, device_id id) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            RB_TRACE("grabbing device");
+            auto device = ctx->get_device(id);
+
+            if (device == nullptr) {
+                RB_TRACE("device not found");
+                ctx->log_warning(u8"reset_latency: device %1% not found", id);
+                return 0;
+            }
+
+            device->get_latency().reset();
+            return 1;
+        });
+    }
+
+    // frame serialization
+    RB_API frame_encoder* RB_APICALL_POST rb_minput_create_encoder(context* ctx, device_id id, api_int precision) {
+        RB_TRACE_ENTER();
+
+        return with_guard<frame_encoder*>(RB_GUARD_ARGS [&]() -> frame_encoder* {
+            if (precision < 0 || precision > max_frame_precision) {
+                RB_TRACE("precision out of range");
+                ctx->log_error(u8"create_encoder: precision must be between 0 and %1% (got %2%)", max_frame_precision, precision);
+                return nullptr;
+            }
+
+            if (ctx->get_device(id) == nullptr) {
+                RB_TRACE("device not found");
+                ctx->log_warning(u8"create_encoder: device %1% not found", id);
+                return nullptr;
+            }
+
+            RB_TRACE("creating encoder");
+            return new (ctx) frame_encoder(id, precision);
+        });
+    }
+
+    RB_API size_t RB_APICALL_POST rb_minput_encode_frame(context* ctx, frame_encoder* encoder, uint8_t* buffer, size_t buffer_size, api_int* sequence) {
+        RB_TRACE_ENTER();
+
+        return with_guard<size_t>(RB_GUARD_ARGS [&](){
+            if (encoder == nullptr) {
+                RB_TRACE("nullptr encoder");
+                ctx->log_error(u8"encode_frame: encoder handle must not be NULL");
+                return size_t{};
+            }
+
+            if (buffer == nullptr) {
+                RB_TRACE("nullptr buffer");
+                ctx->log_error(u8"encode_frame: buffer must not be NULL");
+                return size_t{};
+            }
+
+            RB_TRACE("grabbing device");
+            auto device = ctx->get_device(encoder->get_device());
+
+            if (device == nullptr) {
+                RB_TRACE("device not found");
+                ctx->log_warning(u8"encode_frame: device %1% not found", encoder->get_device());
+                return size_t{};
+            }
+
+            RB_TRACE("encoding frame");
+            frame_sequence encoded{};
+            auto written = encoder->encode(*device, buffer, buffer_size, encoded);
+
+            if (written == 0) {
+                RB_TRACE("buffer too small");
+                ctx->log_warning(u8"encode_frame: frame doesn't fit in %1% bytes", buffer_size);
+                return size_t{};
+            }
+
+            if (sequence != nullptr) {
+                *sequence = encoded;
+            }
+
+            return written;
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_ack_frame(context* ctx, frame_encoder* encoder, api_int sequence) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            if (encoder == nullptr) {
+                RB_TRACE("nullptr encoder");
+                ctx->log_error(u8"ack_frame: encoder handle must not be NULL");
+                return 0;
+            }
+
+            RB_TRACE("acknowledging frame");
+            encoder->ack(static_cast<frame_sequence>(sequence));
+            return 1;
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_destroy_encoder(context* ctx, frame_encoder* encoder) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            if (encoder == nullptr) {
+                RB_TRACE("nullptr encoder");
+                ctx->log_error(u8"destroy_encoder: encoder handle must not be NULL");
+                return 0;
+            }
+
+            RB_TRACE("destroying encoder");
+            delete encoder;
+            return 1;
+        });
+    }
+
+    RB_API frame_decoder* RB_APICALL_POST rb_minput_create_decoder(context* ctx, device_id* mirror) {
+        RB_TRACE_ENTER();
+
+        return with_guard<frame_decoder*>(RB_GUARD_ARGS [&](){
+            RB_TRACE("creating decoder");
+            auto decoder = new (ctx) frame_decoder(ctx);
+
+            if (mirror != nullptr) {
+                *mirror = decoder->get_mirror();
+            }
+
+            return decoder;
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_decode_frame(context* ctx, frame_decoder* decoder, const uint8_t* buffer, size_t buffer_size, api_int* sequence) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            if (decoder == nullptr) {
+                RB_TRACE("nullptr decoder");
+                ctx->log_error(u8"decode_frame: decoder handle must not be NULL");
+                return 0;
+            }
+
+            if (buffer == nullptr) {
+                RB_TRACE("nullptr buffer");
+                ctx->log_error(u8"decode_frame: buffer must not be NULL");
+                return 0;
+            }
+
+            RB_TRACE("decoding frame");
+            frame_sequence decoded{};
+
+            if (!decoder->decode(buffer, buffer_size, decoded)) {
+                RB_TRACE("frame rejected");
+                ctx->log_warning(u8"decode_frame: frame is malformed or its baseline is missing");
+                return 0;
+            }
+
+            if (sequence != nullptr) {
+                *sequence = decoded;
+            }
+
+            return 1;
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_destroy_decoder(context* ctx, frame_decoder* decoder) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            if (decoder == nullptr) {
+                RB_TRACE("nullptr decoder");
+                ctx->log_error(u8"destroy_decoder: decoder handle must not be NULL");
+                return 0;
+            }
+
+            RB_TRACE("destroying decoder");
+            delete decoder;
+            return 1;
+        });
+    }
+
+    // input history
+    RB_API api_bool RB_APICALL_POST rb_minput_set_history_capacity(context* ctx, size_t capacity) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            RB_TRACE("resizing history");
+            ctx->get_history().set_capacity(capacity);
+            return 1;
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_get_history_range(context* ctx, frame_number* oldest, frame_number* newest) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            if (oldest == nullptr || newest == nullptr) {
+                RB_TRACE("nullptr oldest or newest");
+                ctx->log_error(u8"get_history_range: oldest and newest must not be NULL");
+                return 0;
+            }
+
+            auto&& history = ctx->get_history();
+            if (history.empty()) {
+                RB_TRACE("nothing recorded");
+                return 0;
+            }
+
+            *oldest = history.get_oldest();
+            *newest = history.get_newest();
+            return 1;
+        });
+    }
+
+    RB_API size_t RB_APICALL_POST rb_minput_get_history_devices(context* ctx, frame_number frame, device_id* buffer, size_t buffer_size) {
+        RB_TRACE_ENTER();
+
+        return with_guard<size_t>(RB_GUARD_ARGS [&](){
+            auto view = ctx->get_history().get(frame);
+
+            if (!view) {
+                RB_TRACE("frame not recorded");
+                ctx->log_warning(u8"get_history_devices: frame %1% is not in the history", frame);
+                return size_t{};
+            }
+
+            RB_TRACE("copying device ids");
+            auto count = std::min(view.get_device_count(), buffer != nullptr ? buffer_size : 0);
+            for (size_t idx = 0; idx < count; ++idx) {
+                buffer[idx] = view.get_device(idx);
+            }
+
+            return view.get_device_count();
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_get_history_values(context* ctx, frame_number frame, device_id id, const input_code* codes, size_t count, api_float* values) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            if ((codes == nullptr || values == nullptr) && count > 0) {
+                RB_TRACE("nullptr codes or values");
+                ctx->log_error(u8"get_history_values: codes and values must not be NULL");
+                return 0;
+            }
+
+            auto view = ctx->get_history().get(frame);
+
+            if (!view) {
+                RB_TRACE("frame not recorded");
+                ctx->log_warning(u8"get_history_values: frame %1% is not in the history", frame);
+                return 0;
+            }
+
+            auto snapshot = view.find(id);
+
+            if (snapshot == nullptr) {
+                RB_TRACE("device not found");
+                ctx->log_warning(u8"get_history_values: device %1% not found at frame %2%", id, frame);
+                return 0;
+            }
+
+            RB_TRACE("copying values");
+            for (size_t idx = 0; idx < count; ++idx) {
+                // codes the device doesn't have read as 0 like get_value
+                if (!snapshot->get(codes[idx], values[idx])) {
+                    values[idx] = 0;
+                }
+            }
+
+            return 1;
+        });
+    }
+
+    RB_API device_id RB_APICALL_POST rb_minput_create_virtual_device(context* ctx, const virtual_device_desc* desc) {
+        RB_TRACE_ENTER();
+
+        return with_guard<device_id>(RB_GUARD_ARGS [&](){
+            if (desc == nullptr) {
+                RB_TRACE("nullptr desc");
+                ctx->log_error(u8"create_virtual_device: descriptor must not be NULL");
+                return device_id{0};
+            }
+
+            if (desc->m_codes == nullptr && desc->m_code_count > 0) {
+                RB_TRACE("nullptr codes");
+                ctx->log_error(u8"create_virtual_device: codes must not be NULL");
+                return device_id{0};
+            }
+
+            RB_TRACE("creating virtual device");
+            auto id = ctx->get_next_id();
+            ctx->add_device(std::unique_ptr<device>{new (ctx) virtual_device(ctx, id, *desc)});
+            return id;
+        });
+    }
+
+    RB_API size_t RB_APICALL_POST rb_minput_inject(context* ctx, device_id id, const virtual_event* events, size_t count) {
+        RB_TRACE_ENTER();
+
+        return with_guard<size_t>(RB_GUARD_ARGS [&](){
+            if (events == nullptr && count > 0) {
+                RB_TRACE("nullptr events");
+                ctx->log_error(u8"inject: events must not be NULL");
+                return size_t{0};
+            }
+
+            RB_TRACE("grabbing device");
+            auto device = dynamic_cast<virtual_device*>(ctx->get_device(id));
+
+            if (device == nullptr) {
+                RB_TRACE("virtual device not found");
+                ctx->log_warning(u8"inject: virtual device %1% not found", id);
+                return size_t{0};
+            }
+
+            RB_TRACE("injecting events");
+            return device->inject(events, count);
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_destroy_virtual_device(context* ctx, device_id id) {
+        RB_TRACE_ENTER();
+
+        return with_guard<api_bool>(RB_GUARD_ARGS [&](){
+            // platform devices belong to their sources
+            if (dynamic_cast<virtual_device*>(ctx->get_device(id)) == nullptr) {
+                RB_TRACE("virtual device not found");
+                ctx->log_warning(u8"destroy_virtual_device: virtual device %1% not found", id);
+                return 0;
+            }
+
+            RB_TRACE("removing virtual device");
+            ctx->remove_device(id);
+            return 1;
+        });
+    }
+
+    RB_API api_bool RB_APICALL_POST rb_minput_parse_input_code(const char* name, size_t length, input_code* code) {
+        RB_TRACE_ENTER();
+
+        if (name == nullptr || code == nullptr) {
+            RB_TRACE("nullptr name or code");
+            return 0;
+        }
+
+        if (!parse_input_code(name, length, *code)) {
+            RB_TRACE("unknown name");
+            *code = input_code::none;
+            return 0;
+        }
+
+        return 1;
+    }
 }
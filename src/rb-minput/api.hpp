@@ -12,6 +12,12 @@ namespace multi_input {
     RB_API api_bool RB_APICALL_POST rb_minput_set_stderr_log_sink(options*);
     RB_API api_bool RB_APICALL_POST rb_minput_set_custom_log_sink(options*, log_callback, user_data);
     RB_API api_bool RB_APICALL_POST rb_minput_set_device_callback(options*, device_callback, user_data);
+    RB_API api_bool RB_APICALL_POST rb_minput_set_allocator(options*, alloc_callback, free_callback, user_data);
+    RB_API api_bool RB_APICALL_POST rb_minput_set_sources(options*, api_int);
+    RB_API api_bool RB_APICALL_POST rb_minput_set_device_classes(options*, api_int);
+    RB_API api_bool RB_APICALL_POST rb_minput_set_lazy_sources(options*, api_bool);
+    RB_API api_bool RB_APICALL_POST rb_minput_set_shared_sources(options*, api_bool);
+    RB_API api_bool RB_APICALL_POST rb_minput_set_drain_budget(options*, api_int, api_int);
     RB_API api_bool RB_APICALL_POST rb_minput_destroy_options(options*);
 
     RB_API context* RB_APICALL_POST rb_minput_create(options*);
@@ -19,9 +25,14 @@ namespace multi_input {
     RB_API api_bool RB_APICALL_POST rb_minput_set_options(context*, options*);
     RB_API api_bool RB_APICALL_POST rb_minput_destroy(context*);
     RB_API api_bool RB_APICALL_POST rb_minput_reset(context*);
+    RB_API api_bool RB_APICALL_POST rb_minput_open_sources(context*, api_int);
 
     // events
     RB_API api_bool RB_APICALL_POST rb_minput_drain_events(context*);
+    RB_API api_bool RB_APICALL_POST rb_minput_drain_devices(context*, const device_id*, size_t);
+    RB_API api_bool RB_APICALL_POST rb_minput_drain_slices(context*, event_time, event_time, api_int);
+    RB_API api_bool RB_APICALL_POST rb_minput_commit_slice(context*);
+    RB_API api_bool RB_APICALL_POST rb_minput_wait_events(context*, api_int);
 
     // device list
     RB_API enumeration* RB_APICALL_POST rb_minput_get_devices(context*);
@@ -33,6 +44,10 @@ namespace multi_input {
     RB_API api_bool RB_APICALL_POST rb_minput_is_usable(context*, device_id);
     RB_API api_bool RB_APICALL_POST rb_minput_can_vibrate(context*, device_id);
     RB_API api_bool RB_APICALL_POST rb_minput_vibrate(context*, device_id, int, float, float);
+    // unlike the rest of the api these two may be called from any thread while
+    // the context exists, their log messages are delivered by the next drain
+    RB_API api_bool RB_APICALL_POST rb_minput_play_haptics(context*, device_id, const haptics_keyframe*, size_t);
+    RB_API api_bool RB_APICALL_POST rb_minput_stop_haptics(context*, device_id);
     RB_API api_bool RB_APICALL_POST rb_minput_reset_device(context*, device_id);
     RB_API size_t RB_APICALL_POST rb_minput_get_axis_count(context*, device_id);
     RB_API api_bool RB_APICALL_POST rb_minput_get_axes(context*, device_id, input_code*, size_t);
@@ -43,8 +58,52 @@ namespace multi_input {
     RB_API float RB_APICALL_POST rb_minput_get_value(context*, device_id, input_code);
     RB_API float RB_APICALL_POST rb_minput_get_previous(context*, device_id, input_code);
     RB_API float RB_APICALL_POST rb_minput_get_next(context*, device_id, input_code);
+    RB_API api_bool RB_APICALL_POST rb_minput_get_changed_time(context*, device_id, input_code, event_time*);
     RB_API api_bool RB_APICALL_POST rb_minput_set_value(context*, device_id, input_code, float);
     RB_API api_bool RB_APICALL_POST rb_minput_add_value(context*, device_id, input_code, float);
     RB_API api_bool RB_APICALL_POST rb_minput_commit_value(context*, device_id, input_code);
     RB_API api_bool RB_APICALL_POST rb_minput_find_first(context*, find_callback, user_data, input_code*, size_t, device_id*, input_code*);
+
+    // digital channels
+    RB_API api_bool RB_APICALL_POST rb_minput_any_held(context*, device_id);
+    RB_API api_bool RB_APICALL_POST rb_minput_all_held(context*, device_id, const input_code*, size_t);
+    RB_API size_t RB_APICALL_POST rb_minput_get_pressed(context*, device_id, input_code*, size_t);
+    RB_API size_t RB_APICALL_POST rb_minput_get_released(context*, device_id, input_code*, size_t);
+    RB_API api_bool RB_APICALL_POST rb_minput_get_transitions(context*, device_id, const input_code*, size_t, api_int*, api_int*);
+
+    // patterns
+    RB_API api_bool RB_APICALL_POST rb_minput_add_pattern(context*, pattern_kind, const pattern_step*, size_t, api_int*);
+    RB_API api_bool RB_APICALL_POST rb_minput_remove_pattern(context*, api_int);
+    RB_API size_t RB_APICALL_POST rb_minput_get_matches(context*, pattern_match*, size_t);
+
+    // actions
+    RB_API api_bool RB_APICALL_POST rb_minput_set_bindings(context*, size_t, size_t, const action_binding*, size_t);
+    RB_API api_bool RB_APICALL_POST rb_minput_evaluate_actions(context*, api_float*, size_t);
+
+    // latency
+    RB_API api_bool RB_APICALL_POST rb_minput_get_latency(context*, device_id, latency_stats*);
+    RB_API api_bool RB_APICALL_POST rb_minput_reset_latency(context*, device_id);
+
+    // frame serialization
+    RB_API frame_encoder* RB_APICALL_POST rb_minput_create_encoder(context*, device_id, api_int);
+    RB_API size_t RB_APICALL_POST rb_minput_encode_frame(context*, frame_encoder*, uint8_t*, size_t, api_int*);
+    RB_API api_bool RB_APICALL_POST rb_minput_ack_frame(context*, frame_encoder*, api_int);
+    RB_API api_bool RB_APICALL_POST rb_minput_destroy_encoder(context*, frame_encoder*);
+    RB_API frame_decoder* RB_APICALL_POST rb_minput_create_decoder(context*, device_id*);
+    RB_API api_bool RB_APICALL_POST rb_minput_decode_frame(context*, frame_decoder*, const uint8_t*, size_t, api_int*);
+    RB_API api_bool RB_APICALL_POST rb_minput_destroy_decoder(context*, frame_decoder*);
+
+    // input history
+    RB_API api_bool RB_APICALL_POST rb_minput_set_history_capacity(context*, size_t);
+    RB_API api_bool RB_APICALL_POST rb_minput_get_history_range(context*, frame_number*, frame_number*);
+    RB_API size_t RB_APICALL_POST rb_minput_get_history_devices(context*, frame_number, device_id*, size_t);
+    RB_API api_bool RB_APICALL_POST rb_minput_get_history_values(context*, frame_number, device_id, const input_code*, size_t, api_float*);
+
+    // virtual devices
+    RB_API device_id RB_APICALL_POST rb_minput_create_virtual_device(context*, const virtual_device_desc*);
+    RB_API size_t RB_APICALL_POST rb_minput_inject(context*, device_id, const virtual_event*, size_t);
+    RB_API api_bool RB_APICALL_POST rb_minput_destroy_virtual_device(context*, device_id);
+
+    // input codes
+    RB_API api_bool RB_APICALL_POST rb_minput_parse_input_code(const char*, size_t, input_code*);
 }
@@ -46,9 +46,19 @@ namespace multi_input {
     struct options;
     struct enumeration;
     struct api_device;
+    struct haptics_keyframe;
+    struct pattern_step;
+    struct pattern_match;
+    struct action_binding;
+    struct latency_stats;
+    struct frame_encoder;
+    struct frame_decoder;
+    struct virtual_device_desc;
+    struct virtual_event;
     enum class log_level;
     enum class input_code;
     enum class device_event;
+    enum class pattern_kind;
 
     using api_string = const char*;
     using user_data = void*;
@@ -56,7 +66,14 @@ namespace multi_input {
     using api_int = int32_t;
     using api_float = float;
     using device_id = int64_t;
+    // microseconds on the monotonic clock (steady_clock) where the platform allows it
+    using event_time = uint64_t;
+    // counts the commits of a context: one per drain_events, or one per
+    // commit_slice when slicing
+    using frame_number = uint64_t;
     using log_callback = void(RB_APICALL *)(user_data, log_level, api_string /* message */);
     using find_callback = api_bool(RB_APICALL *)(user_data, device_id, input_code, api_float, api_float, api_float);
     using device_callback = void(RB_APICALL *)(user_data, device_event, device_id, api_device*);
+    using alloc_callback = void*(RB_APICALL *)(user_data, size_t /* size */, size_t /* alignment */);
+    using free_callback = void(RB_APICALL *)(user_data, void*, size_t /* size */);
 }
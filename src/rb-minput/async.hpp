@@ -0,0 +1,403 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+// optional C++20 layer over context, the library itself stays C++14
+// and nothing in it includes this header
+
+#if !defined(__cpp_impl_coroutine)
+#   error async.hpp requires C++20 coroutines
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <optional>
+#include <vector>
+
+#include "context.hpp"
+#include "device.hpp"
+#include "latency.hpp"
+
+namespace multi_input {
+    namespace async {
+        using duration = std::chrono::microseconds;
+        constexpr duration no_timeout = duration::max();
+
+        // a committed change of one code, digital codes report 1 and 0
+        struct input_event {
+            device_id m_device;
+            input_code m_code;
+            float m_value;
+            event_time m_time;
+        };
+
+        // fire-and-forget coroutine, starts immediately and frees itself when done
+        // any coroutine type can await the loop's awaitables, this one is for convenience
+        struct task {
+            struct promise_type {
+                task get_return_object() noexcept {
+                    return {};
+                }
+
+                std::suspend_never initial_suspend() noexcept {
+                    return {};
+                }
+
+                std::suspend_never final_suspend() noexcept {
+                    return {};
+                }
+
+                void return_void() noexcept {
+                }
+
+                void unhandled_exception() noexcept {
+                    std::terminate();
+                }
+            };
+        };
+
+        struct event_loop;
+
+        namespace detail {
+            enum class wait_kind {
+                event,
+                pressed,
+                released,
+                sleep,
+            };
+
+            // registered with the loop while its coroutine is suspended,
+            // unregisters itself if the coroutine is destroyed first
+            struct waiter {
+                waiter(event_loop& loop, wait_kind kind, device_id id, input_code code, duration timeout);
+                ~waiter();
+
+                waiter(const waiter&) = delete;
+                waiter& operator=(const waiter&) = delete;
+
+                event_loop* m_loop;
+                wait_kind m_kind;
+                device_id m_device;
+                input_code m_code;
+                event_time m_deadline;
+                std::coroutine_handle<> m_handle;
+                bool m_registered;
+                bool m_satisfied;
+                std::optional<input_event> m_event;
+            };
+
+            inline event_time deadline_after(duration timeout) {
+                if (timeout == no_timeout) {
+                    return wait_forever;
+                }
+
+                return steady_now() + static_cast<event_time>(std::max(timeout.count(), duration::rep{0}));
+            }
+        }
+
+        // resumes to the next input_event, nullopt on timeout
+        struct event_awaitable {
+            bool await_ready();
+            void await_suspend(std::coroutine_handle<>);
+            std::optional<input_event> await_resume();
+
+            detail::waiter m_waiter;
+        };
+
+        // resumes to true once the code went down (or up) during a drain,
+        // false on timeout or if the device disappears
+        struct transition_awaitable {
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<>);
+
+            bool await_resume() const noexcept {
+                return m_waiter.m_satisfied;
+            }
+
+            detail::waiter m_waiter;
+        };
+
+        struct sleep_awaitable {
+            bool await_ready() const noexcept {
+                return m_waiter.m_deadline <= steady_now();
+            }
+
+            void await_suspend(std::coroutine_handle<>);
+
+            void await_resume() const noexcept {
+            }
+
+            detail::waiter m_waiter;
+        };
+
+        struct async_device {
+            transition_awaitable pressed(input_code, duration = no_timeout) const;
+            transition_awaitable released(input_code, duration = no_timeout) const;
+
+            event_loop* m_loop;
+            device_id m_id;
+        };
+
+        // single-threaded driver, run_once blocks on the sources' descriptors
+        // until something arrives or the nearest timeout passes, then drains
+        // the context and resumes every coroutine whose condition holds
+        // coroutines run on the thread calling run_once, which must own the context
+        struct event_loop {
+            explicit event_loop(context& ctx) : m_ctx(&ctx), m_waiters(), m_ready(), m_events() {}
+
+            event_loop(const event_loop&) = delete;
+            event_loop& operator=(const event_loop&) = delete;
+
+            context& get_context() {
+                return *m_ctx;
+            }
+
+            event_awaitable next_event(duration timeout = no_timeout) {
+                return event_awaitable{{*this, detail::wait_kind::event, 0, input_code::none, timeout}};
+            }
+
+            async_device device(device_id id) {
+                return async_device{this, id};
+            }
+
+            sleep_awaitable sleep(duration time) {
+                return sleep_awaitable{{*this, detail::wait_kind::sleep, 0, input_code::none, time}};
+            }
+
+            bool has_waiters() const {
+                return !m_waiters.empty();
+            }
+
+            void run_once() {
+                if (m_events.empty() || !has_event_waiter()) {
+                    auto deadline = nearest_deadline();
+                    auto now = steady_now();
+
+                    if (deadline == wait_forever) {
+                        m_ctx->wait_events(wait_forever);
+                    } else if (deadline > now) {
+                        m_ctx->wait_events(deadline - now);
+                    }
+                }
+
+                m_ctx->drain_events();
+                collect_events();
+                dispatch();
+            }
+
+            // returns once no coroutine waits on the loop anymore
+            void run() {
+                while (has_waiters()) {
+                    run_once();
+                }
+            }
+        private:
+            friend struct detail::waiter;
+            friend struct event_awaitable;
+            friend struct transition_awaitable;
+            friend struct sleep_awaitable;
+
+            // events nobody picks up are dropped oldest first
+            static constexpr size_t max_queued_events = 4096;
+
+            void add(detail::waiter& waiter) {
+                waiter.m_registered = true;
+                m_waiters.push_back(&waiter);
+            }
+
+            void remove(detail::waiter& waiter) {
+                m_waiters.erase(std::remove(m_waiters.begin(), m_waiters.end(), &waiter), m_waiters.end());
+                m_ready.erase(std::remove(m_ready.begin(), m_ready.end(), &waiter), m_ready.end());
+                waiter.m_registered = false;
+            }
+
+            bool pop_event(std::optional<input_event>& event) {
+                if (m_events.empty()) {
+                    return false;
+                }
+
+                event = m_events.front();
+                m_events.pop_front();
+                return true;
+            }
+
+            bool has_event_waiter() const {
+                return std::any_of(m_waiters.begin(), m_waiters.end(), [](const detail::waiter* waiter) {
+                    return waiter->m_kind == detail::wait_kind::event;
+                });
+            }
+
+            event_time nearest_deadline() const {
+                auto result = wait_forever;
+
+                for (auto waiter : m_waiters) {
+                    result = std::min(result, waiter->m_deadline);
+                }
+
+                return result;
+            }
+
+            void push_event(device_id id, input_code code, float value, event_time time) {
+                if (m_events.size() >= max_queued_events) {
+                    m_events.pop_front();
+                }
+
+                m_events.push_back(input_event{id, code, value, time});
+            }
+
+            void collect_events() {
+                m_ctx->for_each_device([&](multi_input::device& dev) {
+                    auto&& digital = dev.get_digital();
+                    auto id = dev.get_id();
+
+                    digital_channels::for_each(digital.present(), [&](size_t slot) {
+                        auto pressed = digital_channels::test(digital.pressed(), slot);
+                        auto released = digital_channels::test(digital.released(), slot);
+                        auto code = from_digital_slot(slot);
+                        auto time = digital.get_changed(slot);
+
+                        // both in one frame is a tap, or a release and press again if it's held now
+                        if (digital.get(slot)) {
+                            if (released) {
+                                push_event(id, code, 0, time);
+                            }
+
+                            if (pressed) {
+                                push_event(id, code, 1, time);
+                            }
+                        } else {
+                            if (pressed) {
+                                push_event(id, code, 1, time);
+                            }
+
+                            if (released) {
+                                push_event(id, code, 0, time);
+                            }
+                        }
+                    });
+
+                    for (size_t slot = 0; slot < analog_code_count; ++slot) {
+                        auto code = from_analog_slot(slot);
+                        auto axis = dev.get_axis(code);
+
+                        if (axis != nullptr && axis->get() != axis->get_previous()) {
+                            push_event(id, code, axis->get(), axis->get_changed());
+                        }
+                    }
+                });
+            }
+
+            bool is_ready(detail::waiter& waiter, event_time now) {
+                switch (waiter.m_kind) {
+                    case detail::wait_kind::event:
+                        if (pop_event(waiter.m_event)) {
+                            return true;
+                        }
+                        break;
+                    case detail::wait_kind::pressed:
+                    case detail::wait_kind::released: {
+                        auto dev = m_ctx->get_device(waiter.m_device);
+                        if (dev == nullptr) {
+                            return true;
+                        }
+
+                        auto axis = dev->get_axis(waiter.m_code);
+                        if (axis == nullptr) {
+                            return true;
+                        }
+
+                        auto count = waiter.m_kind == detail::wait_kind::pressed ? axis->get_presses() : axis->get_releases();
+                        if (count > 0) {
+                            waiter.m_satisfied = true;
+                            return true;
+                        }
+                        break;
+                    }
+                    case detail::wait_kind::sleep:
+                        break;
+                }
+
+                return waiter.m_deadline <= now;
+            }
+
+            void dispatch() {
+                auto now = steady_now();
+
+                for (auto waiter : m_waiters) {
+                    if (is_ready(*waiter, now)) {
+                        m_ready.push_back(waiter);
+                    }
+                }
+
+                for (auto waiter : m_ready) {
+                    m_waiters.erase(std::find(m_waiters.begin(), m_waiters.end(), waiter));
+                }
+
+                // resumed coroutines may suspend again or destroy waiters still in the list
+                while (!m_ready.empty()) {
+                    auto waiter = m_ready.front();
+                    m_ready.erase(m_ready.begin());
+                    waiter->m_registered = false;
+                    waiter->m_handle.resume();
+                }
+            }
+
+            context* m_ctx;
+            std::vector<detail::waiter*> m_waiters;
+            std::vector<detail::waiter*> m_ready;
+            std::deque<input_event> m_events;
+        };
+
+        namespace detail {
+            inline waiter::waiter(event_loop& loop, wait_kind kind, device_id id, input_code code, duration timeout) :
+                m_loop(&loop), m_kind(kind), m_device(id), m_code(code), m_deadline(deadline_after(timeout)),
+                m_handle(), m_registered(false), m_satisfied(false), m_event()
+            {
+            }
+
+            inline waiter::~waiter() {
+                if (m_registered) {
+                    m_loop->remove(*this);
+                }
+            }
+        }
+
+        inline bool event_awaitable::await_ready() {
+            return m_waiter.m_loop->pop_event(m_waiter.m_event);
+        }
+
+        inline void event_awaitable::await_suspend(std::coroutine_handle<> handle) {
+            m_waiter.m_handle = handle;
+            m_waiter.m_loop->add(m_waiter);
+        }
+
+        inline std::optional<input_event> event_awaitable::await_resume() {
+            return m_waiter.m_event;
+        }
+
+        inline void transition_awaitable::await_suspend(std::coroutine_handle<> handle) {
+            m_waiter.m_handle = handle;
+            m_waiter.m_loop->add(m_waiter);
+        }
+
+        inline void sleep_awaitable::await_suspend(std::coroutine_handle<> handle) {
+            m_waiter.m_handle = handle;
+            m_waiter.m_loop->add(m_waiter);
+        }
+
+        inline transition_awaitable async_device::pressed(input_code code, duration timeout) const {
+            return transition_awaitable{{*m_loop, detail::wait_kind::pressed, m_id, code, timeout}};
+        }
+
+        inline transition_awaitable async_device::released(input_code code, duration timeout) const {
+            return transition_awaitable{{*m_loop, detail::wait_kind::released, m_id, code, timeout}};
+        }
+    }
+}
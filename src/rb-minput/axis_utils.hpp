@@ -5,6 +5,8 @@
 
 #include <cmath>
 
+#include "input_code.hpp"
+
 namespace multi_input {
     struct device;
 
@@ -15,6 +17,11 @@ namespace multi_input {
     void derive_mouse_pre_commit(device&);
     void derive_mouse_post_commit(device&);
 
+    // axes reporting motion since the last commit, zeroed by derive_mouse_post_commit
+    inline bool is_relative_axis(input_code code) {
+        return code == input_code::mouse_x || code == input_code::mouse_y || code == input_code::mouse_wheel;
+    }
+
     inline float apply_deadzone(float value, float abs_max, float deadzone) {
         if (value <= deadzone) {
             return 0;
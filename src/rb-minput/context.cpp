@@ -4,6 +4,9 @@
 #include <iostream>
 #include <exception>
 #include <memory>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 #include <boost/exception/diagnostic_information.hpp>
 #include <boost/range/iterator_range_core.hpp>
@@ -14,8 +17,11 @@
 #include "device.hpp"
 #include "source.hpp"
 #include "device_event.hpp"
+#include "latency.hpp"
+#include "source_hub.hpp"
 
 #if defined(RB_PLATFORM_LINUX)
+#   include "linux/posix.hpp"
 #   include "linux/xi2/xi2_source.hpp"
 #   include "linux/evdev/evdev_source.hpp"
 #elif defined(RB_PLATFORM_WINDOWS)
@@ -39,7 +45,9 @@ namespace multi_input {
     }
 
     options::options()
-        : m_log_sink(null_log_sink), m_device_callback(null_device_callback), m_log_level(log_level::info)
+        : m_log_sink(null_log_sink), m_device_callback(null_device_callback), m_log_level(log_level::info),
+          m_allocator(default_allocator()), m_sources(all_sources), m_device_classes(all_device_classes),
+          m_lazy_sources(false), m_shared_sources(false), m_drain_events(0), m_drain_time(0)
     {
     }
 
@@ -67,34 +75,124 @@ namespace multi_input {
         m_device_callback = callback;
     }
 
+    void options::set_allocator(allocator alloc) {
+        m_allocator = alloc;
+    }
+
+    void options::set_sources(api_int sources) {
+        m_sources = sources;
+    }
+
+    void options::set_device_classes(api_int classes) {
+        m_device_classes = classes;
+    }
+
+    void options::set_lazy_sources(bool lazy) {
+        m_lazy_sources = lazy;
+    }
+
+    void options::set_shared_sources(bool shared) {
+        m_shared_sources = shared;
+    }
+
+    void options::set_drain_budget(api_int events, api_int microseconds) {
+        m_drain_events = std::max(events, api_int{0});
+        m_drain_time = std::max(microseconds, api_int{0});
+    }
+
     context::context(options opts)
-        : m_options(opts), m_sources(), m_devices(), m_next_unique_id(1)
+        : m_options(opts),
+          m_memory(std::make_unique<memory_pool>(opts.m_allocator)),
+          m_haptics_mutex(), m_haptics(0, std::hash<device_id>{}, std::equal_to<device_id>{}, haptics_map::allocator_type{*m_memory}),
+          m_deferred_log(),
+          m_sources(),
+          m_devices(0, std::hash<device_id>{}, std::equal_to<device_id>{}, device_map::allocator_type{*m_memory}),
+          m_next_unique_id(1), m_active_kind(0), m_recognizer(), m_actions(), m_history(*m_memory), m_slicer(), m_slicing(false), m_buffered(false), m_budget(), m_first_source(0), m_wait_fds()
+#if defined(RB_PLATFORM_LINUX)
+          , m_wait_polls()
+#endif
     {
         RB_TRACE_ENTER();
 
 #if defined(RB_PLATFORM_LINUX)
-        RB_TRACE("adding XI2 source");
-        log_debug("Adding source: X11 XInput2");
-        add_source<lnx::xi2_source>();
-
-        RB_TRACE("adding evdev source");
-        log_debug("Adding source: evdev");
-        add_source<lnx::evdev_source>();
+        add_platform_source<lnx::xi2_source, source_kind::xi2>(u8"X11 XInput2", device_class::keyboard | device_class::mouse);
+        add_platform_source<lnx::evdev_source, source_kind::evdev>(u8"evdev", static_cast<api_int>(device_class::gamepad));
 #elif defined(RB_PLATFORM_WINDOWS)
-        RB_TRACE("adding Raw Input source");
-        log_debug("Adding source: Raw Input");
-        add_source<windows::raw_input_source>();
-
-        RB_TRACE("adding XInput source");
-        log_debug("Adding source: XInput");
-        add_source<windows::xinput_source>();
+        add_platform_source<windows::raw_input_source, source_kind::raw_input>(u8"Raw Input", device_class::keyboard | device_class::mouse);
+        add_platform_source<windows::xinput_source, source_kind::xinput>(u8"XInput", static_cast<api_int>(device_class::gamepad));
 #elif defined(RB_PLATFORM_OSX)
-        RB_TRACE("adding HIDManager source");
-        log_debug("Adding source: HIDManager");
-        add_source<osx::hidm_source>();
+        add_platform_source<osx::hidm_source, source_kind::hidm>(u8"HIDManager", all_device_classes);
 #else
 #   error Add platform sources.
 #endif
+
+        if (!m_options.m_lazy_sources) {
+            RB_TRACE("opening all sources");
+            open_sources(all_device_classes);
+        }
+    }
+
+    template <typename T, source_kind Kind>
+    void context::add_platform_source(api_string name, api_int classes) {
+        if (m_options.m_shared_sources) {
+            add_source<hub_source_for<Kind>>(name, Kind, classes);
+        } else {
+            add_source<T>(name, Kind, classes);
+        }
+    }
+
+    void context::open_sources(api_int classes) {
+        for (auto&& entry : m_sources) {
+            if (entry.m_attempted) {
+                continue;
+            }
+
+            if ((m_options.m_sources & static_cast<api_int>(entry.m_kind)) == 0) {
+                continue;
+            }
+
+            if ((entry.m_classes & m_options.m_device_classes & classes) == 0) {
+                continue;
+            }
+
+            open_source(entry);
+        }
+    }
+
+    void context::open_sources_for(const input_code* codes, size_t count) {
+        api_int classes = 0;
+        for (size_t idx = 0; idx < count; ++idx) {
+            classes |= device_class_of(codes[idx]);
+        }
+
+        open_sources(classes);
+    }
+
+    void context::open_source_kind(source_kind kind) {
+        for (auto&& entry : m_sources) {
+            if (entry.m_kind == kind && !entry.m_attempted) {
+                open_source(entry);
+            }
+        }
+    }
+
+    void context::open_source(source_entry& entry) {
+        RB_TRACE_ENTER();
+
+        entry.m_attempted = true;
+        log_debug("Adding source: %1%", entry.m_name);
+
+        m_active_kind = static_cast<api_int>(entry.m_kind);
+
+        try {
+            auto source = entry.m_factory(this);
+            source->enum_devices();
+            entry.m_source = std::move(source);
+        } catch (...) {
+            log_exception();
+        }
+
+        m_active_kind = 0;
     }
 
     void context::set_options(const options& opts) {
@@ -106,13 +204,191 @@ namespace multi_input {
     }
 
     void context::drain_events() {
-        for (auto&& source : m_sources) {
-            source->drain_events();
+        // slices left over are committed together with the new events
+        m_slicer.flush(*this);
+        drain_sources();
+        commit_devices();
+    }
+
+    void context::drain_slices(event_time start, event_time end, size_t count) {
+        m_slicer.flush(*this);
+        start_slicing();
+        drain_sources();
+        m_slicer.split(*this, start, end, count);
+    }
+
+    void context::start_slicing() {
+        if (m_slicing) {
+            return;
+        }
+
+        m_slicing = true;
+
+        for (auto&& pair : m_devices) {
+            pair.second->set_recording(true);
+        }
+    }
+
+    bool context::commit_slice() {
+        if (!m_slicer.apply_next(*this)) {
+            return false;
+        }
+
+        commit_devices();
+        return true;
+    }
+
+    void context::drain_sources() {
+        flush_deferred_log();
+
+        // sources with their own event timestamps override this per event
+        auto now = steady_now();
+
+        for (auto&& pair : m_devices) {
+            pair.second->set_event_time(now);
+        }
+
+        m_budget = drain_budget{
+            m_options.m_drain_events > 0 ? static_cast<size_t>(m_options.m_drain_events) : drain_budget::no_event_limit,
+            m_options.m_drain_time > 0 ? now + static_cast<event_time>(m_options.m_drain_time) : drain_budget::no_deadline
+        };
+
+        auto count = m_sources.size();
+
+        for (size_t idx = 0; idx < count; ++idx) {
+            drain_source(m_sources[(m_first_source + idx) % count], [](source& src) {
+                src.drain_events();
+            });
         }
 
+        if (m_budget.is_limited() && count > 0) {
+            m_first_source = (m_first_source + 1) % count;
+        }
+
+        // drains outside drain_events (sync, hub pumps) aren't limited
+        m_budget = drain_budget{};
+    }
+
+    drain_budget& context::get_drain_budget() {
+        return m_budget;
+    }
+
+    void context::commit_devices() {
+        m_recognizer.clear_matches();
+        m_buffered = false;
+
+        // everything drained so far becomes visible with this commit
+        auto visible = steady_now();
+
         for (auto&& pair : m_devices) {
-            pair.second->commit();
+            m_recognizer.feed(*pair.second);
+            pair.second->get_latency().publish(visible);
+            pair.second->commit_frame();
         }
+
+        m_history.record(*this);
+    }
+
+    void context::drain_devices(const device_id* ids, size_t count) {
+        flush_deferred_log();
+        m_slicer.flush(*this);
+
+        auto now = steady_now();
+
+        for (size_t idx = 0; idx < count; ++idx) {
+            auto dev = get_device(ids[idx]);
+            if (dev != nullptr) {
+                dev->set_event_time(now);
+            }
+        }
+
+        for (auto&& entry : m_sources) {
+            drain_source(entry, [&](source& src) {
+                src.drain_devices(ids, count);
+            });
+        }
+
+        auto visible = steady_now();
+
+        // matches stay until the next drain_events, so late patterns are appended
+        for (size_t idx = 0; idx < count; ++idx) {
+            // a repeated id would commit twice and lose the previous state
+            if (std::find(ids, ids + idx, ids[idx]) != ids + idx) {
+                continue;
+            }
+
+            // sources may have removed the device while draining
+            auto dev = get_device(ids[idx]);
+            if (dev == nullptr) {
+                continue;
+            }
+
+            m_recognizer.feed(*dev);
+            dev->get_latency().publish(visible);
+            dev->commit_frame();
+        }
+    }
+
+    bool context::get_wait_fds(std::vector<int>& fds) {
+        auto buffered = m_buffered;
+
+        for (auto&& entry : m_sources) {
+            if (entry.m_source != nullptr && entry.m_source->get_wait_fds(fds)) {
+                buffered = true;
+            }
+        }
+
+        return buffered;
+    }
+
+    bool context::wait_events(event_time timeout) {
+        m_wait_fds.clear();
+
+        if (get_wait_fds(m_wait_fds)) {
+            return true;
+        }
+
+#if defined(RB_PLATFORM_LINUX)
+        if (m_wait_fds.empty()) {
+            // no descriptors could ever wake us (set_sources(0), only
+            // virtual or decoded devices), don't block
+            return sleep_briefly(timeout);
+        }
+
+        m_wait_polls.clear();
+
+        for (auto fd : m_wait_fds) {
+            m_wait_polls.emplace_back(pollfd{ fd, POLLIN, 0 });
+        }
+
+        timespec duration{};
+        duration.tv_sec = static_cast<time_t>(timeout / 1000000);
+        duration.tv_nsec = static_cast<long>(timeout % 1000000) * 1000;
+
+        auto rc = ppoll(m_wait_polls.data(), m_wait_polls.size(), timeout == wait_forever ? nullptr : &duration, nullptr);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                return false;
+            }
+
+            lnx::throw_posix_error("Failed to wait for events");
+        }
+
+        return rc > 0;
+#else
+        // raw input and hid manager deliver through the message loop, not descriptors
+        return sleep_briefly(timeout);
+#endif
+    }
+
+    bool context::sleep_briefly(event_time timeout) {
+        constexpr event_time max_sleep = 1000;
+        std::this_thread::sleep_for(std::chrono::microseconds(std::min(timeout, max_sleep)));
+        return true;
+    }
+
+    void context::mark_buffered() {
+        m_buffered = true;
     }
 
     void context::reset() {
@@ -137,6 +413,23 @@ namespace multi_input {
         log_error(u8"Native exception caught: %1%", info);
     }
 
+    void context::log_deferred_exception() {
+        auto ptr = std::current_exception();
+        if (ptr == nullptr) {
+            return;
+        }
+
+        auto info = boost::current_exception_diagnostic_information();
+        log_deferred(log_level::error, u8"Native exception caught: %1%", info);
+    }
+
+    void context::flush_deferred_log() {
+        // an empty queue is a single exchange, nothing is allocated
+        m_deferred_log.consume([&](deferred_message&& message) {
+            log(message.m_level, message.m_message);
+        });
+    }
+
     device* context::get_device(device_id id) {
         auto it = m_devices.find(id);
         if (it == m_devices.end()) {
@@ -146,15 +439,24 @@ namespace multi_input {
         }
     }
 
-    std::vector<device*> context::get_devices() {
-        std::vector<device*> buffer{};
-        buffer.reserve(m_devices.size());
+    size_t context::get_device_count() const {
+        return m_devices.size();
+    }
 
-        for (auto&& pair : m_devices) {
-            buffer.emplace_back(pair.second.get());
-        }
+    memory_pool& context::get_memory() {
+        return *m_memory;
+    }
+
+    recognizer& context::get_recognizer() {
+        return m_recognizer;
+    }
+
+    action_table& context::get_actions() {
+        return m_actions;
+    }
 
-        return buffer;
+    input_history& context::get_history() {
+        return m_history;
     }
 
     device_id context::get_next_id() {
@@ -164,6 +466,19 @@ namespace multi_input {
     void context::add_device(std::unique_ptr<device> dev) {
         auto id = dev->get_id();
         log_debug(u8"Adding device %s (%s)", id, dev->get_name());
+
+        if (dev->get_source_kind() == 0) {
+            dev->set_source_kind(m_active_kind);
+        }
+
+        dev->set_recording(m_slicing);
+
+        auto target = dev->get_haptics_target();
+        if (target != nullptr) {
+            std::lock_guard<std::mutex> lock{m_haptics_mutex};
+            m_haptics[id] = std::move(target);
+        }
+
         m_devices.emplace(id, std::move(dev));
 
         notify_device(id, device_event::created);
@@ -176,7 +491,16 @@ namespace multi_input {
         }
 
         log_debug(u8"Removing device %1% (%2%)", id, it->second->get_name());
+
+        {
+            std::lock_guard<std::mutex> lock{m_haptics_mutex};
+            m_haptics.erase(id);
+        }
+
         m_devices.erase(it);
+        m_recognizer.remove_device(id);
+        m_actions.remove_device(id);
+        m_history.remove_device(id);
 
         notify_device(id, device_event::removed);
     }
@@ -229,13 +553,11 @@ namespace multi_input {
             }
 
             if (begin == nullptr || end == nullptr) {
-                auto supported = dev.get_axis_codes();
-                if (supported.size() == 0) {
-                    continue;
-                }
+                auto found = dev.any_axis_code([&](input_code code) {
+                    return find_first_device(callback, dev, &code, &code + 1, out_id, out_code);
+                });
 
-                auto it = &supported[0];
-                if (find_first_device(callback, dev, it, it + supported.size(), out_id, out_code)) {
+                if (found) {
                     return true;
                 }
             } else if (find_first_device(callback, dev, begin, end, out_id, out_code)) {
@@ -245,4 +567,20 @@ namespace multi_input {
 
         return false;
     }
+
+    bool context::play_haptics(device_id id, haptics_timeline timeline) {
+        std::shared_ptr<haptics_target> target;
+
+        {
+            std::lock_guard<std::mutex> lock{m_haptics_mutex};
+
+            auto it = m_haptics.find(id);
+            if (it != m_haptics.end()) {
+                target = it->second;
+            }
+        }
+
+        // played outside the lock, the device may be removed meanwhile
+        return target != nullptr && target->play(std::move(timeline));
+    }
 }
@@ -9,13 +9,27 @@
 #include <unordered_set>
 #include <functional>
 #include <string>
+#include <mutex>
 
 #include "utils.hpp"
 #include "api_types.hpp"
 #include "log_level.hpp"
 #include "device.hpp"
 #include "source.hpp"
+#include "source_flags.hpp"
+#include "recognizer.hpp"
+#include "actions.hpp"
+#include "input_history.hpp"
+#include "input_slicer.hpp"
+#include "drain_budget.hpp"
+#include "memory.hpp"
 #include "format.hpp"
+#include "haptics.hpp"
+#include "mpsc_queue.hpp"
+
+#if defined(RB_PLATFORM_LINUX)
+#   include <poll.h>
+#endif
 
 namespace multi_input {
     struct options {
@@ -32,18 +46,43 @@ namespace multi_input {
         void set_custom_log_sink(log_callback);
         void set_null_device_callback();
         void set_custom_device_callback(device_callback);
+
+        // only used when a context is created, set_options keeps the old one
+        void set_allocator(allocator);
+
+        // masks of source_kind and device_class bits, a source is opened
+        // only if it's enabled and provides at least one enabled class
+        void set_sources(api_int);
+        void set_device_classes(api_int);
+        // lazy sources are opened by the first query that needs their classes
+        void set_lazy_sources(bool);
+        // shared sources are read once per process by the source_hub and
+        // mirrored into every context that uses them
+        void set_shared_sources(bool);
+        // bounds a single drain, 0 disables either limit, sources read
+        // whole reports and round-robin across devices that have more
+        void set_drain_budget(api_int events, api_int microseconds);
     private:
         friend struct context;
 
         log_callback m_log_sink;
         device_callback m_device_callback;
         log_level m_log_level;
+        allocator m_allocator;
+        api_int m_sources;
+        api_int m_device_classes;
+        bool m_lazy_sources;
+        bool m_shared_sources;
+        api_int m_drain_events;
+        api_int m_drain_time;
     };
 
+    constexpr event_time wait_forever = static_cast<event_time>(-1);
+
     struct context {
         using find_callback = std::function<bool(device_id, input_code, float, float, float)>;
 
-        RB_MOVEABLE(context);
+        RB_NON_MOVEABLE(context);
 
         explicit context(options);
 
@@ -51,8 +90,36 @@ namespace multi_input {
         const options& get_options() const;
 
         void drain_events();
+        void drain_devices(const device_id*, size_t);
         void reset();
 
+        // the two halves of drain_events, the source hub publishes the
+        // drained state before committing it
+        void drain_sources();
+        void commit_devices();
+
+        // drains the sources without committing and splits the changes into
+        // count slices of [start, end), see input_slicer
+        // analog writes are only logged for slicing from the first call on,
+        // the ones made before it (e.g. injected) all go to its first slice
+        void drain_slices(event_time start, event_time end, size_t count);
+        // commits the next slice, false once all were committed
+        bool commit_slice();
+
+        // what the running drain may still read
+        drain_budget& get_drain_budget();
+
+        // blocks until an opened source has events to drain or the timeout
+        // (microseconds, wait_forever for none) passes, false on timeout
+        // without descriptors to wait on (platforms without waitable sources,
+        // no sources opened) it sleeps briefly and reports true
+        bool wait_events(event_time);
+        // see source::get_wait_fds, changes marked buffered count as well
+        bool get_wait_fds(std::vector<int>&);
+        // for changes made outside the sources (injection, decoded frames),
+        // waits return right away until the next commit
+        void mark_buffered();
+
         template <typename... Args>
         void log_verbose(const std::string& fmt, Args&&... args) {
 #ifdef RB_DEBUG
@@ -80,11 +147,28 @@ namespace multi_input {
             log_args(log_level::error, fmt, std::forward<Args>(args)...);
         }
 
+        // for threads other than the one draining the context, the message
+        // is formatted right away and passed to the sink by the next drain
+        template <typename... Args>
+        void log_deferred(log_level level, const std::string& fmt, Args&&... args) {
+            m_deferred_log.push(deferred_message{level, format(fmt, std::forward<Args>(args)...)});
+        }
+
         void log(log_level, const std::string&);
         void log_exception();
+        void log_deferred_exception();
 
         device* get_device(device_id);
-        std::vector<device*> get_devices();
+        size_t get_device_count() const;
+
+        template <typename Fn>
+        void for_each_device(Fn&& fn) {
+            for (auto&& pair : m_devices) {
+                fn(*pair.second);
+            }
+        }
+
+        memory_pool& get_memory();
 
         device_id get_next_id();
         void add_device(std::unique_ptr<device>);
@@ -92,18 +176,68 @@ namespace multi_input {
         void notify_device(device_id, device_event);
 
         bool find_first(find_callback, input_code*, input_code*, device_id*, input_code*);
+
+        // safe to call from any thread, haptics targets are looked up in a
+        // table of their own and never through the device map
+        // an empty timeline stops playback, false if the device is unknown
+        // or has no haptics
+        bool play_haptics(device_id, haptics_timeline);
+
+        recognizer& get_recognizer();
+        action_table& get_actions();
+        input_history& get_history();
+
+        // opens the not yet opened sources that provide any of the classes
+        void open_sources(api_int);
+        void open_sources_for(const input_code*, size_t);
+        // opens the source of the given kind regardless of the options
+        void open_source_kind(source_kind);
     private:
+        using source_factory = std::unique_ptr<source>(*)(context*);
+
+        struct source_entry {
+            api_string m_name;
+            source_kind m_kind;
+            api_int m_classes;
+            source_factory m_factory;
+            // a source is tried once, a failing one isn't retried by later queries
+            bool m_attempted;
+            std::unique_ptr<source> m_source;
+        };
+
         template <typename T>
-        void add_source() {
-            RB_TRACE_ENTER();
+        static std::unique_ptr<source> make_source(context* ctx) {
+            return std::make_unique<T>(ctx);
+        }
+
+        template <typename T>
+        void add_source(api_string name, source_kind kind, api_int classes) {
+            m_sources.push_back(source_entry{name, kind, classes, &make_source<T>, false, nullptr});
+        }
+
+        // registers the platform source, or its hub mirror for shared sources
+        template <typename T, source_kind Kind>
+        void add_platform_source(api_string, api_int);
+
+        void open_source(source_entry&);
+
+        // a source that throws loses its own events for the frame, the
+        // other sources and the commit still run
+        template <typename Fn>
+        void drain_source(source_entry& entry, Fn&& fn) {
+            if (entry.m_source == nullptr) {
+                return;
+            }
+
+            m_active_kind = static_cast<api_int>(entry.m_kind);
 
             try {
-                auto source = std::make_unique<T>(this);
-                source->enum_devices();
-                m_sources.emplace_back(std::move(source));
+                fn(*entry.m_source);
             } catch (...) {
                 log_exception();
             }
+
+            m_active_kind = 0;
         }
 
         template <typename... Args>
@@ -111,9 +245,61 @@ namespace multi_input {
             log(level, format(fmt_str, std::forward<Args>(args)...));
         }
 
+        struct deferred_message {
+            log_level m_level;
+            std::string m_message;
+        };
+
+        void flush_deferred_log();
+        bool sleep_briefly(event_time);
+        // devices only log analog writes for the slicer once it's used
+        void start_slicing();
+
+        using device_map = std::unordered_map<
+            device_id,
+            std::unique_ptr<device>,
+            std::hash<device_id>,
+            std::equal_to<device_id>,
+            pool_allocator<std::pair<const device_id, std::unique_ptr<device>>>
+        >;
+
+        // only changed by the owning thread, so the pool is never used elsewhere
+        using haptics_map = std::unordered_map<
+            device_id,
+            std::shared_ptr<haptics_target>,
+            std::hash<device_id>,
+            std::equal_to<device_id>,
+            pool_allocator<std::pair<const device_id, std::shared_ptr<haptics_target>>>
+        >;
+
         options m_options;
-        std::vector<std::unique_ptr<source>> m_sources;
-        std::unordered_map<device_id, std::unique_ptr<device>> m_devices;
+        std::unique_ptr<memory_pool> m_memory;
+        // declared before the sources so they outlive them: a source's
+        // worker may still log or hold targets while it shuts down
+        std::mutex m_haptics_mutex;
+        haptics_map m_haptics;
+        mpsc_queue<deferred_message> m_deferred_log;
+        std::vector<source_entry> m_sources;
+        device_map m_devices;
         device_id m_next_unique_id;
+        // kind of the source currently running, stamped on the devices it adds
+        api_int m_active_kind;
+        recognizer m_recognizer;
+        action_table m_actions;
+        input_history m_history;
+        input_slicer m_slicer;
+        // drain_slices was called at least once
+        bool m_slicing;
+        // see mark_buffered
+        bool m_buffered;
+        drain_budget m_budget;
+        // the source drained first, rotated so a spent budget doesn't
+        // always starve the same sources
+        size_t m_first_source;
+        std::vector<int> m_wait_fds;
+#if defined(RB_PLATFORM_LINUX)
+        // reused by every wait, like m_wait_fds
+        std::vector<pollfd> m_wait_polls;
+#endif
     };
 }
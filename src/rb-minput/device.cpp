@@ -7,10 +7,24 @@
 
 namespace multi_input {
     device::device(context* ctx, device_id id) :
-        m_ctx(ctx), m_id(id), m_meta(), m_axes(), m_is_usable(true)
+        m_ctx(ctx), m_id(id), m_meta(),
+        m_axes(0, std::hash<input_code>{}, std::equal_to<input_code>{}, axis_map::allocator_type{ctx->get_memory()}),
+        m_digital(), m_analog_log(ctx->get_memory()), m_latency(), m_source_kind(0), m_is_usable(true)
     {
     }
 
+    void* device::operator new(size_t size, context* ctx) {
+        return pool_new(ctx->get_memory(), size);
+    }
+
+    void device::operator delete(void* ptr, context*) {
+        pool_delete(ptr);
+    }
+
+    void device::operator delete(void* ptr) {
+        pool_delete(ptr);
+    }
+
     device::~device() {
     }
 
@@ -47,50 +61,117 @@ namespace multi_input {
         return false;
     }
 
-    virtual_axis* device::get_axis(input_code code) {
+    std::shared_ptr<haptics_target> device::get_haptics_target() {
+        return nullptr;
+    }
+
+    axis_ref device::get_axis(input_code code) {
         if (code == input_code::none) {
             return nullptr;
         }
 
+        auto slot = to_digital_slot(code);
+        if (slot != no_digital_slot) {
+            if (!m_digital.has(slot)) {
+                return nullptr;
+            }
+
+            return axis_ref{&m_digital, slot};
+        }
+
         auto it = m_axes.find(code);
         if (it == m_axes.end()) {
             return nullptr;
         } else {
-            return &it->second;
+            return axis_ref{&it->second, m_digital.get_time(), code, &m_analog_log};
         }
     }
 
-    virtual_axis* device::add_axis(input_code code) {
+    axis_ref device::add_axis(input_code code) {
         if (code == input_code::none) {
             return nullptr;
         }
 
+        auto slot = to_digital_slot(code);
+        if (slot != no_digital_slot) {
+            m_digital.add(slot);
+            return axis_ref{&m_digital, slot};
+        }
+
         auto pair = m_axes.emplace(code, virtual_axis{});
         auto it = pair.first;
-        return &it->second;
-    }
-
-    size_t device::get_axis_count() const {
-        return m_axes.size();
+        return axis_ref{&it->second, m_digital.get_time(), code, &m_analog_log};
     }
 
-    std::vector<input_code> device::get_axis_codes() {
-        std::vector<input_code> codes{};
-        codes.reserve(m_axes.size());
+    void device::copy_layout(const device& other) {
+        m_meta = other.m_meta;
 
-        for (auto&& pair : m_axes) {
-            codes.emplace_back(pair.first);
+        for (auto&& pair : other.m_axes) {
+            add_axis(pair.first);
         }
 
-        return codes;
+        digital_channels::for_each(other.m_digital.present(), [&](size_t slot) {
+            m_digital.add(slot);
+        });
+    }
+
+    size_t device::get_axis_count() const {
+        return m_axes.size() + m_digital.count();
     }
 
     void device::reset() {
         for (auto&& pair : m_axes) {
             auto&& axis = pair.second;
-            axis.set(0);
+            axis.set(0, m_digital.get_time());
             axis.commit();
         }
+
+        m_analog_log.clear();
+        m_digital.reset();
+    }
+
+    void device::set_recording(bool recording) {
+        m_analog_log.set_recording(recording);
+    }
+
+    void device::take_changes(std::vector<input_change>& changes) {
+        auto&& transitions = m_digital.get_log();
+        auto&& writes = m_analog_log.get_changes();
+        auto digital = transitions.begin();
+        auto analog = writes.begin();
+
+        // both logs are in source order, merge them by time
+        while (digital != transitions.end() || analog != writes.end()) {
+            if (analog == writes.end() || (digital != transitions.end() && digital->m_time <= analog->m_time)) {
+                changes.push_back(input_change{from_digital_slot(digital->m_slot), false, digital->m_pressed ? 1.0f : 0.0f, digital->m_time});
+                ++digital;
+            } else {
+                changes.push_back(input_change{analog->m_code, analog->m_add, analog->m_value, analog->m_time});
+                ++analog;
+            }
+        }
+
+        for (auto it = writes.rbegin(); it != writes.rend(); ++it) {
+            it->m_axis->restore(it->m_old, it->m_old_time);
+        }
+
+        m_analog_log.clear();
+        m_digital.rewind();
+    }
+
+    void device::apply_change(const input_change& change) {
+        set_event_time(change.m_time);
+
+        auto axis = get_axis(change.m_code);
+        if (axis == nullptr) {
+            return;
+        }
+
+        if (change.m_add) {
+            axis->add(change.m_value);
+        } else {
+            axis->set(change.m_value);
+        }
     }
 
     void device::commit() {
@@ -98,5 +179,12 @@ namespace multi_input {
             auto&& axis = pair.second;
             axis.commit();
         }
+
+        m_digital.commit();
+    }
+
+    void device::commit_frame() {
+        commit();
+        m_analog_log.clear();
     }
 }
@@ -4,12 +4,17 @@
 #pragma once
 
 #include <unordered_map>
+#include <memory>
 #include <vector>
 
 #include "utils.hpp"
 #include "api_types.hpp"
 #include "input_code.hpp"
 #include "virtual_axis.hpp"
+#include "haptics.hpp"
+#include "memory.hpp"
+#include "latency.hpp"
+#include "source_flags.hpp"
 
 namespace multi_input {
     struct context;
@@ -57,10 +62,25 @@ namespace multi_input {
         std::string m_serial;
     };
 
+    // an uncommitted write to one code, as taken out of a device
+    // relative writes (add) accumulate, the others set the value
+    struct input_change {
+        input_code m_code;
+        bool m_add;
+        float m_value;
+        event_time m_time;
+    };
+
     struct device {
         RB_NON_MOVEABLE(device);
         virtual ~device();
 
+        // devices live in the owning context's memory pool,
+        // create them with new (ctx) T(ctx, ...)
+        static void* operator new(size_t, context*);
+        static void operator delete(void*, context*);
+        static void operator delete(void*);
+
         device_id get_id() const;
         const std::string& get_name() const;
 
@@ -69,23 +89,86 @@ namespace multi_input {
 
         virtual bool can_vibrate() const;
         virtual bool vibrate(int, float, float);
+        // null for devices without haptics, the context registers the
+        // target once the device is added
+        virtual std::shared_ptr<haptics_target> get_haptics_target();
         virtual void commit();
+        // commit, then forgets the analog writes the commit made itself
+        // (derived axes, zeroed relative axes) so take_changes skips them
+        void commit_frame();
 
-        virtual_axis* get_axis(input_code);
+        axis_ref get_axis(input_code);
         size_t get_axis_count() const;
-        std::vector<input_code> get_axis_codes();
         void reset();
+
+        // moves every write since the last commit out, oldest first, and
+        // rewinds the uncommitted state so they can be applied in portions
+        void take_changes(std::vector<input_change>&);
+        // analog writes are only logged for take_changes while recording
+        void set_recording(bool);
+        // applies a taken change the way a source would report it
+        void apply_change(const input_change&);
+
+        // stops at the first code for which fn returns true
+        template <typename Fn>
+        bool any_axis_code(Fn&& fn) const {
+            for (auto&& pair : m_axes) {
+                if (fn(pair.first)) {
+                    return true;
+                }
+            }
+
+            return m_digital.any_present([&](size_t slot) {
+                return fn(from_digital_slot(slot));
+            });
+        }
+
+        const digital_channels& get_digital() const {
+            return m_digital;
+        }
+
+        void set_event_time(event_time time) {
+            m_digital.set_time(time);
+        }
+
+        latency_tracker& get_latency() {
+            return m_latency;
+        }
+
+        // source_kind bit of the source that created the device, 0 for devices
+        // added outside of a source, set by the context when the device is added
+        api_int get_source_kind() const {
+            return m_source_kind;
+        }
+
+        void set_source_kind(api_int kind) {
+            m_source_kind = kind;
+        }
     protected:
         friend struct api_device;
 
         device(context*, device_id);
-        virtual_axis* add_axis(input_code);
+        axis_ref add_axis(input_code);
         device_meta& get_meta();
+        // takes over the meta and the set of axes, not their values
+        void copy_layout(const device&);
 
         context* m_ctx;
         device_id m_id;
+        using axis_map = std::unordered_map<
+            input_code,
+            virtual_axis,
+            std::hash<input_code>,
+            std::equal_to<input_code>,
+            pool_allocator<std::pair<const input_code, virtual_axis>>
+        >;
+
         device_meta m_meta;
-        std::unordered_map<input_code, virtual_axis> m_axes;
+        axis_map m_axes;
+        digital_channels m_digital;
+        analog_log m_analog_log;
+        latency_tracker m_latency;
+        api_int m_source_kind;
         bool m_is_usable;
     };
 
@@ -0,0 +1,338 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "utils.hpp"
+#include "input_code.hpp"
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+namespace multi_input {
+    // digital (button/key) codes are stored as bits instead of virtual_axis entries,
+    // one slot per digital code in numeric order (see to_digital_slot in input_code.hpp)
+    constexpr size_t digital_slot_count  = digital_code_count;
+    constexpr size_t digital_word_bits   = 64;
+    constexpr size_t digital_word_count  = (digital_slot_count + digital_word_bits - 1) / digital_word_bits;
+
+    using digital_word = uint64_t;
+    using digital_bits = std::array<digital_word, digital_word_count>;
+
+    // transition counters saturate instead of wrapping around
+    using digital_count = uint8_t;
+    using digital_counts = std::array<digital_count, digital_slot_count>;
+    constexpr digital_count max_digital_count = 255;
+
+    struct digital_transition {
+        size_t m_slot;
+        bool m_pressed;
+        event_time m_time;
+    };
+
+    inline int popcount(digital_word word) {
+#if defined(_MSC_VER)
+        return static_cast<int>(__popcnt64(word));
+#else
+        return __builtin_popcountll(word);
+#endif
+    }
+
+    inline size_t trailing_zeros(digital_word word) {
+#if defined(_MSC_VER)
+        unsigned long index{};
+        _BitScanForward64(&index, word);
+        return static_cast<size_t>(index);
+#else
+        return static_cast<size_t>(__builtin_ctzll(word));
+#endif
+    }
+
+    // per-device current/previous/next state of all digital codes
+    // the word loops are short and branch-free so the compiler can vectorize them
+    // besides the state, every press and release between commits is counted,
+    // so a tap that starts and ends within one frame is still visible
+    struct digital_channels {
+        RB_COPYABLE(digital_channels);
+
+        digital_channels() :
+            m_present(), m_current(), m_previous(), m_next(),
+            m_pressed(), m_released(), m_pressed_next(), m_released_next(),
+            m_presses(), m_releases(), m_presses_next(), m_releases_next(),
+            m_changed(), m_time(), m_log()
+        {
+            m_log.reserve(initial_log_capacity);
+        }
+
+        static digital_word mask_of(size_t slot) {
+            return digital_word{1} << (slot % digital_word_bits);
+        }
+
+        static size_t word_of(size_t slot) {
+            return slot / digital_word_bits;
+        }
+
+        static bool test(const digital_bits& bits, size_t slot) {
+            return (bits[word_of(slot)] & mask_of(slot)) != 0;
+        }
+
+        static void assign(digital_bits& bits, size_t slot, bool value) {
+            if (value) {
+                bits[word_of(slot)] |= mask_of(slot);
+            } else {
+                bits[word_of(slot)] &= ~mask_of(slot);
+            }
+        }
+
+        bool has(size_t slot) const {
+            return test(m_present, slot);
+        }
+
+        void add(size_t slot) {
+            assign(m_present, slot, true);
+        }
+
+        size_t count() const {
+            size_t result = 0;
+            for (size_t idx = 0; idx < digital_word_count; ++idx) {
+                result += popcount(m_present[idx]);
+            }
+            return result;
+        }
+
+        void set(size_t slot, bool value) {
+            if (test(m_next, slot) == value) {
+                return;
+            }
+
+            assign(m_next, slot, value);
+            m_log.push_back(digital_transition{slot, value, m_time});
+
+            if (value) {
+                assign(m_pressed_next, slot, true);
+                increment(m_presses_next[slot]);
+            } else {
+                assign(m_released_next, slot, true);
+                increment(m_releases_next[slot]);
+            }
+        }
+
+        void commit() {
+            m_previous = m_current;
+            m_current = m_next;
+
+            m_pressed = m_pressed_next;
+            m_released = m_released_next;
+            m_pressed_next = digital_bits{};
+            m_released_next = digital_bits{};
+
+            m_presses = m_presses_next;
+            m_releases = m_releases_next;
+            m_presses_next = digital_counts{};
+            m_releases_next = digital_counts{};
+
+            for (auto&& transition : m_log) {
+                m_changed[transition.m_slot] = transition.m_time;
+            }
+
+            m_log.clear();
+        }
+
+        void commit(size_t slot) {
+            assign(m_previous, slot, test(m_current, slot));
+            assign(m_current, slot, test(m_next, slot));
+
+            assign(m_pressed, slot, test(m_pressed_next, slot));
+            assign(m_released, slot, test(m_released_next, slot));
+            assign(m_pressed_next, slot, false);
+            assign(m_released_next, slot, false);
+
+            m_presses[slot] = m_presses_next[slot];
+            m_releases[slot] = m_releases_next[slot];
+            m_presses_next[slot] = 0;
+            m_releases_next[slot] = 0;
+
+            // the log is kept for the full commit, which stores the same times again
+            for (auto&& transition : m_log) {
+                if (transition.m_slot == slot) {
+                    m_changed[slot] = transition.m_time;
+                }
+            }
+        }
+
+        // undoes every transition since the last full commit, the log is
+        // the caller's to replay
+        void rewind() {
+            for (auto it = m_log.rbegin(); it != m_log.rend(); ++it) {
+                assign(m_next, it->m_slot, !it->m_pressed);
+            }
+
+            m_pressed_next = digital_bits{};
+            m_released_next = digital_bits{};
+            m_presses_next = digital_counts{};
+            m_releases_next = digital_counts{};
+            m_log.clear();
+        }
+
+        // releases everything that is held, counting it as a release
+        void reset() {
+            for_each(m_next, [&](size_t slot) {
+                increment(m_releases_next[slot]);
+            });
+
+            for (size_t idx = 0; idx < digital_word_count; ++idx) {
+                m_released_next[idx] |= m_next[idx];
+            }
+
+            m_next = digital_bits{};
+            commit();
+        }
+
+        bool get(size_t slot) const {
+            return test(m_current, slot);
+        }
+
+        bool get_previous(size_t slot) const {
+            return test(m_previous, slot);
+        }
+
+        bool get_next(size_t slot) const {
+            return test(m_next, slot);
+        }
+
+        // went down at least once during the last committed frame
+        const digital_bits& pressed() const {
+            return m_pressed;
+        }
+
+        // went up at least once during the last committed frame
+        const digital_bits& released() const {
+            return m_released;
+        }
+
+        // number of presses/releases during the last committed frame
+        int get_presses(size_t slot) const {
+            return m_presses[slot];
+        }
+
+        int get_releases(size_t slot) const {
+            return m_releases[slot];
+        }
+
+        const digital_bits& held() const {
+            return m_current;
+        }
+
+        const digital_bits& present() const {
+            return m_present;
+        }
+
+        // timestamp of the last committed transition
+        event_time get_changed(size_t slot) const {
+            return m_changed[slot];
+        }
+
+        // timestamp recorded with transitions from now on
+        void set_time(event_time time) {
+            m_time = time;
+        }
+
+        event_time get_time() const {
+            return m_time;
+        }
+
+        // transitions since the last full commit, in order
+        const std::vector<digital_transition>& get_log() const {
+            return m_log;
+        }
+
+        bool any_held() const {
+            digital_word result = 0;
+            for (size_t idx = 0; idx < digital_word_count; ++idx) {
+                result |= m_current[idx];
+            }
+            return result != 0;
+        }
+
+        size_t held_count() const {
+            size_t result = 0;
+            for (size_t idx = 0; idx < digital_word_count; ++idx) {
+                result += popcount(m_current[idx]);
+            }
+            return result;
+        }
+
+        bool all_held(const digital_bits& mask) const {
+            digital_word missing = 0;
+            for (size_t idx = 0; idx < digital_word_count; ++idx) {
+                missing |= mask[idx] & ~m_current[idx];
+            }
+            return missing == 0;
+        }
+
+        template <typename Fn>
+        bool any_present(Fn&& fn) const {
+            return any_of(m_present, std::forward<Fn>(fn));
+        }
+
+        // stops at the first slot for which fn returns true
+        template <typename Fn>
+        static bool any_of(const digital_bits& bits, Fn&& fn) {
+            for (size_t idx = 0; idx < digital_word_count; ++idx) {
+                auto word = bits[idx];
+                while (word != 0) {
+                    if (fn(idx * digital_word_bits + trailing_zeros(word))) {
+                        return true;
+                    }
+                    word &= word - 1;
+                }
+            }
+            return false;
+        }
+
+        template <typename Fn>
+        static void for_each(const digital_bits& bits, Fn&& fn) {
+            for (size_t idx = 0; idx < digital_word_count; ++idx) {
+                auto word = bits[idx];
+                while (word != 0) {
+                    fn(idx * digital_word_bits + trailing_zeros(word));
+                    word &= word - 1;
+                }
+            }
+        }
+    private:
+        static constexpr size_t initial_log_capacity = 32;
+
+        static void increment(digital_count& count) {
+            if (count < max_digital_count) {
+                ++count;
+            }
+        }
+
+        digital_bits m_present;
+        digital_bits m_current;
+        digital_bits m_previous;
+        digital_bits m_next;
+
+        digital_bits m_pressed;
+        digital_bits m_released;
+        digital_bits m_pressed_next;
+        digital_bits m_released_next;
+
+        digital_counts m_presses;
+        digital_counts m_releases;
+        digital_counts m_presses_next;
+        digital_counts m_releases_next;
+
+        std::array<event_time, digital_slot_count> m_changed;
+        event_time m_time;
+        std::vector<digital_transition> m_log;
+    };
+}
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+
+#include "utils.hpp"
+#include "api_types.hpp"
+#include "latency.hpp"
+
+namespace multi_input {
+    // how much one drain may read, shared by all sources of the drain
+    // sources charge what they read and stop at the next safe point once
+    // it's spent, whatever is left stays queued for the next drain
+    struct drain_budget {
+        RB_COPYABLE(drain_budget);
+
+        static constexpr size_t no_event_limit = std::numeric_limits<size_t>::max();
+        static constexpr event_time no_deadline = std::numeric_limits<event_time>::max();
+
+        drain_budget() : m_events(no_event_limit), m_deadline(no_deadline), m_spent(false) {}
+        drain_budget(size_t events, event_time deadline) : m_events(events), m_deadline(deadline), m_spent(false) {}
+
+        bool is_limited() const {
+            return m_events != no_event_limit || m_deadline != no_deadline;
+        }
+
+        bool is_spent() const {
+            return m_spent;
+        }
+
+        // events a source may read before charging again
+        size_t get_events() const {
+            return m_spent ? 0 : m_events;
+        }
+
+        // the clock is only read here, so sources charge in batches
+        void charge(size_t count) {
+            if (m_events != no_event_limit) {
+                m_events = count < m_events ? m_events - count : 0;
+            }
+
+            if (m_events == 0 || (m_deadline != no_deadline && steady_now() >= m_deadline)) {
+                m_spent = true;
+            }
+        }
+    private:
+        size_t m_events;
+        event_time m_deadline;
+        bool m_spent;
+    };
+}
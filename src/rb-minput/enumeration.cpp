@@ -9,8 +9,13 @@
 
 namespace multi_input {
     enumeration::enumeration(context* ctx)
-        : m_ctx(ctx), m_devices(ctx->get_devices()), m_current(), m_end()
+        : m_ctx(ctx), m_devices(device_list::allocator_type{ctx->get_memory()}), m_current(), m_end()
     {
+        m_devices.reserve(ctx->get_device_count());
+        ctx->for_each_device([&](device& dev) {
+            m_devices.emplace_back(&dev);
+        });
+
         reset();
     }
 
@@ -21,9 +26,22 @@ namespace multi_input {
     }
 
     enumeration::enumeration(enumeration&& other)
-        : m_ctx(other.m_ctx), m_devices(other.m_devices), m_current(), m_end()
+        : m_ctx(other.m_ctx), m_devices(std::move(other.m_devices)), m_current(), m_end()
     {
         reset();
+        other.reset();
+    }
+
+    void* enumeration::operator new(size_t size, context* ctx) {
+        return pool_new(ctx->get_memory(), size);
+    }
+
+    void enumeration::operator delete(void* ptr, context*) {
+        pool_delete(ptr);
+    }
+
+    void enumeration::operator delete(void* ptr) {
+        pool_delete(ptr);
     }
 
     device* enumeration::next() {
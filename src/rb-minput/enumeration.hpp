@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "utils.hpp"
+#include "memory.hpp"
 
 namespace multi_input {
     struct context;
@@ -18,12 +19,20 @@ namespace multi_input {
         enumeration& operator=(const enumeration&) = delete;
         enumeration& operator=(enumeration&&) = delete;
 
+        // enumerations live in the context's memory pool like devices,
+        // create them with new (ctx) enumeration(ctx)
+        static void* operator new(size_t, context*);
+        static void operator delete(void*, context*);
+        static void operator delete(void*);
+
         device* next();
         void reset();
     private:
+        using device_list = std::vector<device*, pool_allocator<device*>>;
+
         context* m_ctx;
-        std::vector<device*> m_devices;
-        std::vector<device*>::iterator m_current;
-        std::vector<device*>::iterator m_end;
+        device_list m_devices;
+        device_list::iterator m_current;
+        device_list::iterator m_end;
     };
 }
@@ -0,0 +1,495 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "frame_codec.hpp"
+#include "device.hpp"
+#include "context.hpp"
+#include "latency.hpp"
+
+// frame layout, all fields little-endian bit order:
+//   16  sequence
+//    1  has baseline, followed by 6 bits of distance back to it
+//    5  precision
+//        keyframes (no baseline) only: digital and analog presence masks
+//    1  digital changed, followed by
+//           1  raw, followed by the xor mask as digital_slot_count bits
+//              or an 8-bit count and the 8-bit slot of every flipped bit
+//    1  analog changed, followed by a 5-bit count and for every entry a
+//       5-bit slot and the zigzag delta in 4-bit groups with a continue bit
+// padded with zeros to a whole byte
+
+namespace multi_input {
+    namespace {
+        constexpr unsigned sequence_bits = 16;
+        constexpr unsigned distance_bits = 6;
+        constexpr unsigned precision_bits = 5;
+        constexpr unsigned digital_count_bits = 8;
+        constexpr unsigned digital_slot_bits = 8;
+        constexpr unsigned analog_count_bits = 5;
+        constexpr unsigned analog_slot_bits = 5;
+        constexpr unsigned varint_group_bits = 4;
+        constexpr unsigned max_varint_groups = 8;
+
+        static_assert(frame_history_size <= (size_t{1} << distance_bits), "distance must fit in the history");
+        static_assert(max_frame_precision < (1 << precision_bits), "precision must fit its field");
+
+        struct bit_writer {
+            bit_writer(uint8_t* buffer, size_t size) :
+                m_buffer(buffer), m_size(size), m_offset(0), m_acc(0), m_acc_bits(0), m_overflow(false)
+            {
+            }
+
+            void write(uint32_t value, unsigned bits) {
+                m_acc |= static_cast<uint64_t>(value) << m_acc_bits;
+                m_acc_bits += bits;
+
+                while (m_acc_bits >= 8) {
+                    put(static_cast<uint8_t>(m_acc));
+                    m_acc >>= 8;
+                    m_acc_bits -= 8;
+                }
+            }
+
+            void write_bool(bool value) {
+                write(value ? 1 : 0, 1);
+            }
+
+            void write_varint(uint32_t value) {
+                do {
+                    write(value & ((1u << varint_group_bits) - 1), varint_group_bits);
+                    value >>= varint_group_bits;
+                    write_bool(value != 0);
+                } while (value != 0);
+            }
+
+            void write_bits(const digital_bits& bits) {
+                for (size_t slot = 0; slot < digital_slot_count; ++slot) {
+                    write_bool(digital_channels::test(bits, slot));
+                }
+            }
+
+            // returns the total size, 0 if anything didn't fit
+            size_t finish() {
+                if (m_acc_bits > 0) {
+                    put(static_cast<uint8_t>(m_acc));
+                    m_acc = 0;
+                    m_acc_bits = 0;
+                }
+
+                return m_overflow ? 0 : m_offset;
+            }
+        private:
+            void put(uint8_t byte) {
+                if (m_offset < m_size) {
+                    m_buffer[m_offset++] = byte;
+                } else {
+                    m_overflow = true;
+                }
+            }
+
+            uint8_t* m_buffer;
+            size_t m_size;
+            size_t m_offset;
+            uint64_t m_acc;
+            unsigned m_acc_bits;
+            bool m_overflow;
+        };
+
+        struct bit_reader {
+            bit_reader(const uint8_t* buffer, size_t size) :
+                m_buffer(buffer), m_size(size), m_offset(0), m_acc(0), m_acc_bits(0), m_overflow(false)
+            {
+            }
+
+            uint32_t read(unsigned bits) {
+                while (m_acc_bits < bits) {
+                    if (m_offset >= m_size) {
+                        m_overflow = true;
+                        return 0;
+                    }
+
+                    m_acc |= static_cast<uint64_t>(m_buffer[m_offset++]) << m_acc_bits;
+                    m_acc_bits += 8;
+                }
+
+                auto value = static_cast<uint32_t>(m_acc & ((uint64_t{1} << bits) - 1));
+                m_acc >>= bits;
+                m_acc_bits -= bits;
+                return value;
+            }
+
+            bool read_bool() {
+                return read(1) != 0;
+            }
+
+            uint32_t read_varint() {
+                uint32_t value = 0;
+
+                for (unsigned group = 0; group < max_varint_groups; ++group) {
+                    value |= read(varint_group_bits) << (group * varint_group_bits);
+
+                    if (!read_bool()) {
+                        return value;
+                    }
+                }
+
+                m_overflow = true;
+                return 0;
+            }
+
+            void read_bits(digital_bits& bits) {
+                for (size_t slot = 0; slot < digital_slot_count; ++slot) {
+                    digital_channels::assign(bits, slot, read_bool());
+                }
+            }
+
+            bool failed() const {
+                return m_overflow;
+            }
+        private:
+            const uint8_t* m_buffer;
+            size_t m_size;
+            size_t m_offset;
+            uint64_t m_acc;
+            unsigned m_acc_bits;
+            bool m_overflow;
+        };
+
+        uint32_t zigzag(int32_t value) {
+            return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+        }
+
+        int32_t unzigzag(uint32_t value) {
+            return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+        }
+
+        int32_t quantize(float value, api_int precision) {
+            auto scaled = std::ldexp(static_cast<double>(value), precision);
+            scaled = std::max(scaled, static_cast<double>(std::numeric_limits<int32_t>::min()));
+            scaled = std::min(scaled, static_cast<double>(std::numeric_limits<int32_t>::max()));
+            return static_cast<int32_t>(std::lround(scaled));
+        }
+
+        float dequantize(int32_t value, api_int precision) {
+            return static_cast<float>(std::ldexp(static_cast<double>(value), -precision));
+        }
+
+        bool has_analog(const input_frame& frame, size_t slot) {
+            return (frame.m_analog_present & (uint32_t{1} << slot)) != 0;
+        }
+
+        bool same_presence(const input_frame& a, const input_frame& b) {
+            return a.m_digital_present == b.m_digital_present && a.m_analog_present == b.m_analog_present;
+        }
+
+        void capture(device& dev, api_int precision, input_frame& frame) {
+            auto&& digital = dev.get_digital();
+            frame.m_digital_present = digital.present();
+            frame.m_digital = digital.held();
+            frame.m_analog_present = 0;
+            frame.m_precision = precision;
+
+            for (size_t slot = 0; slot < analog_code_count; ++slot) {
+                auto axis = dev.get_axis(from_analog_slot(slot));
+
+                if (axis == nullptr) {
+                    frame.m_analog[slot] = 0;
+                } else {
+                    frame.m_analog_present |= uint32_t{1} << slot;
+                    frame.m_analog[slot] = quantize(axis->get(), precision);
+                }
+            }
+        }
+
+        void write_frame(bit_writer& writer, const input_frame& frame, const input_frame& base, bool keyframe) {
+            if (keyframe) {
+                writer.write_bits(frame.m_digital_present);
+
+                for (size_t slot = 0; slot < analog_code_count; ++slot) {
+                    writer.write_bool(has_analog(frame, slot));
+                }
+            }
+
+            digital_bits flipped{};
+            size_t flipped_count = 0;
+
+            for (size_t idx = 0; idx < digital_word_count; ++idx) {
+                flipped[idx] = frame.m_digital[idx] ^ base.m_digital[idx];
+                flipped_count += popcount(flipped[idx]);
+            }
+
+            writer.write_bool(flipped_count > 0);
+
+            if (flipped_count > 0) {
+                // a long list costs more than the whole mask
+                auto raw = digital_count_bits + flipped_count * digital_slot_bits > digital_slot_count;
+                writer.write_bool(raw);
+
+                if (raw) {
+                    writer.write_bits(flipped);
+                } else {
+                    writer.write(static_cast<uint32_t>(flipped_count), digital_count_bits);
+                    digital_channels::for_each(flipped, [&](size_t slot) {
+                        writer.write(static_cast<uint32_t>(slot), digital_slot_bits);
+                    });
+                }
+            }
+
+            size_t changed_count = 0;
+            for (size_t slot = 0; slot < analog_code_count; ++slot) {
+                if (has_analog(frame, slot) && frame.m_analog[slot] != base.m_analog[slot]) {
+                    ++changed_count;
+                }
+            }
+
+            writer.write_bool(changed_count > 0);
+
+            if (changed_count > 0) {
+                writer.write(static_cast<uint32_t>(changed_count), analog_count_bits);
+
+                for (size_t slot = 0; slot < analog_code_count; ++slot) {
+                    if (!has_analog(frame, slot) || frame.m_analog[slot] == base.m_analog[slot]) {
+                        continue;
+                    }
+
+                    // wrapping difference, the decoder wraps it back
+                    auto delta = static_cast<uint32_t>(frame.m_analog[slot]) - static_cast<uint32_t>(base.m_analog[slot]);
+                    writer.write(static_cast<uint32_t>(slot), analog_slot_bits);
+                    writer.write_varint(zigzag(static_cast<int32_t>(delta)));
+                }
+            }
+        }
+
+        bool read_frame(bit_reader& reader, input_frame& frame, bool keyframe) {
+            if (keyframe) {
+                reader.read_bits(frame.m_digital_present);
+
+                for (size_t slot = 0; slot < analog_code_count; ++slot) {
+                    if (reader.read_bool()) {
+                        frame.m_analog_present |= uint32_t{1} << slot;
+                    }
+                }
+            }
+
+            if (reader.read_bool()) {
+                digital_bits flipped{};
+
+                if (reader.read_bool()) {
+                    reader.read_bits(flipped);
+                } else {
+                    auto count = reader.read(digital_count_bits);
+
+                    for (uint32_t idx = 0; idx < count && !reader.failed(); ++idx) {
+                        auto slot = reader.read(digital_slot_bits);
+                        if (slot >= digital_slot_count) {
+                            return false;
+                        }
+
+                        digital_channels::assign(flipped, slot, true);
+                    }
+                }
+
+                for (size_t idx = 0; idx < digital_word_count; ++idx) {
+                    frame.m_digital[idx] ^= flipped[idx];
+                }
+            }
+
+            if (reader.read_bool()) {
+                auto count = reader.read(analog_count_bits);
+
+                for (uint32_t idx = 0; idx < count && !reader.failed(); ++idx) {
+                    auto slot = reader.read(analog_slot_bits);
+                    if (slot >= analog_code_count || !has_analog(frame, slot)) {
+                        return false;
+                    }
+
+                    auto delta = static_cast<uint32_t>(unzigzag(reader.read_varint()));
+                    frame.m_analog[slot] = static_cast<int32_t>(static_cast<uint32_t>(frame.m_analog[slot]) + delta);
+                }
+            }
+
+            for (size_t idx = 0; idx < digital_word_count; ++idx) {
+                frame.m_digital[idx] &= frame.m_digital_present[idx];
+            }
+
+            return !reader.failed();
+        }
+
+        struct mirror_device : device {
+            RB_NON_MOVEABLE(mirror_device);
+
+            mirror_device(context* ctx, device_id id) : device(ctx, id) {
+                auto& meta = get_meta();
+                meta.set_name("Remote device");
+                meta.set_internal_id(format("remote:%1%", id));
+                meta.set_ids(0, 0, 0);
+            }
+
+            void apply(const input_frame& frame) {
+                auto time = steady_now();
+                set_event_time(time);
+                m_latency.record_report(time);
+
+                digital_channels::for_each(frame.m_digital_present, [&](size_t slot) {
+                    m_digital.add(slot);
+                    m_digital.set(slot, digital_channels::test(frame.m_digital, slot));
+                });
+
+                for (size_t slot = 0; slot < analog_code_count; ++slot) {
+                    if (has_analog(frame, slot)) {
+                        add_axis(from_analog_slot(slot))->set(dequantize(frame.m_analog[slot], frame.m_precision));
+                    }
+                }
+            }
+        };
+    }
+
+    frame_encoder::frame_encoder(device_id id, api_int precision) :
+        m_device(id), m_precision(precision), m_next(0), m_has_ack(false), m_acked(0), m_history()
+    {
+    }
+
+    void* frame_encoder::operator new(size_t size, context* ctx) {
+        return pool_new(ctx->get_memory(), size);
+    }
+
+    void frame_encoder::operator delete(void* ptr, context*) {
+        pool_delete(ptr);
+    }
+
+    void frame_encoder::operator delete(void* ptr) {
+        pool_delete(ptr);
+    }
+
+    size_t frame_encoder::encode(device& dev, uint8_t* buffer, size_t size, frame_sequence& sequence) {
+        input_frame frame{};
+        capture(dev, m_precision, frame);
+
+        const input_frame* base = nullptr;
+        auto distance = static_cast<frame_sequence>(m_next - m_acked);
+
+        if (m_has_ack && distance > 0 && distance < frame_history_size) {
+            auto&& acked = m_history[m_acked % frame_history_size];
+
+            if (acked.m_valid && acked.m_sequence == m_acked && same_presence(acked.m_frame, frame)) {
+                base = &acked.m_frame;
+            }
+        }
+
+        input_frame empty{};
+
+        bit_writer writer{buffer, size};
+        writer.write(m_next, sequence_bits);
+        writer.write_bool(base != nullptr);
+        if (base != nullptr) {
+            writer.write(distance, distance_bits);
+        }
+        writer.write(static_cast<uint32_t>(m_precision), precision_bits);
+        write_frame(writer, frame, base != nullptr ? *base : empty, base == nullptr);
+
+        auto written = writer.finish();
+        if (written == 0) {
+            return 0;
+        }
+
+        auto&& stored = m_history[m_next % frame_history_size];
+        stored.m_valid = true;
+        stored.m_sequence = m_next;
+        stored.m_frame = frame;
+
+        sequence = m_next++;
+        return written;
+    }
+
+    void frame_encoder::ack(frame_sequence sequence) {
+        auto&& acked = m_history[sequence % frame_history_size];
+        if (!acked.m_valid || acked.m_sequence != sequence) {
+            return;
+        }
+
+        if (!m_has_ack || sequence_newer(sequence, m_acked)) {
+            m_has_ack = true;
+            m_acked = sequence;
+        }
+    }
+
+    frame_decoder::frame_decoder(context* ctx) :
+        m_ctx(ctx), m_mirror(ctx->get_next_id()), m_has_applied(false), m_applied(0), m_history()
+    {
+        m_ctx->add_device(std::unique_ptr<device>{new (m_ctx) mirror_device(m_ctx, m_mirror)});
+    }
+
+    frame_decoder::~frame_decoder() {
+        m_ctx->remove_device(m_mirror);
+    }
+
+    void* frame_decoder::operator new(size_t size, context* ctx) {
+        return pool_new(ctx->get_memory(), size);
+    }
+
+    void frame_decoder::operator delete(void* ptr, context*) {
+        pool_delete(ptr);
+    }
+
+    void frame_decoder::operator delete(void* ptr) {
+        pool_delete(ptr);
+    }
+
+    bool frame_decoder::decode(const uint8_t* buffer, size_t size, frame_sequence& sequence) {
+        bit_reader reader{buffer, size};
+
+        auto received = static_cast<frame_sequence>(reader.read(sequence_bits));
+        auto has_base = reader.read_bool();
+        auto distance = has_base ? reader.read(distance_bits) : 0;
+        auto precision = static_cast<api_int>(reader.read(precision_bits));
+
+        if (reader.failed() || precision > max_frame_precision || (has_base && distance == 0)) {
+            return false;
+        }
+
+        input_frame frame{};
+
+        if (has_base) {
+            auto base_sequence = static_cast<frame_sequence>(received - distance);
+            auto&& base = m_history[base_sequence % frame_history_size];
+
+            if (!base.m_valid || base.m_sequence != base_sequence || base.m_frame.m_precision != precision) {
+                return false;
+            }
+
+            frame = base.m_frame;
+        }
+
+        frame.m_precision = precision;
+
+        if (!read_frame(reader, frame, !has_base)) {
+            return false;
+        }
+
+        auto&& stored = m_history[received % frame_history_size];
+        stored.m_valid = true;
+        stored.m_sequence = received;
+        stored.m_frame = frame;
+
+        if (!m_has_applied || sequence_newer(received, m_applied)) {
+            m_has_applied = true;
+            m_applied = received;
+            apply(frame);
+        }
+
+        sequence = received;
+        return true;
+    }
+
+    void frame_decoder::apply(const input_frame& frame) {
+        auto dev = m_ctx->get_device(m_mirror);
+        if (dev != nullptr) {
+            static_cast<mirror_device*>(dev)->apply(frame);
+            m_ctx->mark_buffered();
+        }
+    }
+}
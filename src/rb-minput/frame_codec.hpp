@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "utils.hpp"
+#include "api_types.hpp"
+#include "input_code.hpp"
+#include "digital_channels.hpp"
+
+namespace multi_input {
+    struct context;
+    struct device;
+
+    // analog values are sent as value * 2^precision rounded to an integer
+    constexpr api_int max_frame_precision = 24;
+    // frames further back than this can't be used as a baseline
+    constexpr size_t frame_history_size = 64;
+
+    static_assert(digital_slot_count < 256, "digital slots must fit 8 bits");
+    static_assert(analog_code_count < 32, "analog slots must fit 5 bits");
+
+    using frame_sequence = uint16_t;
+
+    // committed state of a device in the form that goes over the wire
+    struct input_frame {
+        digital_bits m_digital_present;
+        digital_bits m_digital;
+        uint32_t m_analog_present;
+        std::array<int32_t, analog_code_count> m_analog;
+        api_int m_precision;
+    };
+
+    // sequences wrap around, a is newer if it's less than half the range ahead
+    inline bool sequence_newer(frame_sequence a, frame_sequence b) {
+        return a != b && static_cast<frame_sequence>(a - b) < 0x8000;
+    }
+
+    // encodes the committed frames of one device, each one as a delta
+    // against the newest frame the remote side acknowledged, or as a
+    // keyframe if there's no usable baseline or the device's axes changed
+    struct frame_encoder {
+        RB_NON_MOVEABLE(frame_encoder);
+
+        frame_encoder(device_id, api_int);
+
+        // encoders live in the context's memory pool like devices,
+        // create them with new (ctx) frame_encoder(...)
+        static void* operator new(size_t, context*);
+        static void operator delete(void*, context*);
+        static void operator delete(void*);
+
+        device_id get_device() const {
+            return m_device;
+        }
+
+        // returns the number of bytes written, 0 if the buffer is too small
+        // in which case the frame isn't recorded and the sequence is reused
+        size_t encode(device&, uint8_t*, size_t, frame_sequence&);
+        // acks of frames that are no longer in the history are ignored
+        void ack(frame_sequence);
+    private:
+        struct entry {
+            bool m_valid;
+            frame_sequence m_sequence;
+            input_frame m_frame;
+        };
+
+        device_id m_device;
+        api_int m_precision;
+        frame_sequence m_next;
+        bool m_has_ack;
+        frame_sequence m_acked;
+        std::array<entry, frame_history_size> m_history;
+    };
+
+    // applies received frames to a mirror device registered in the context,
+    // the mirror's new state becomes visible with the next drain like any
+    // other device's, frames older than the last applied one only serve as
+    // baselines
+    struct frame_decoder {
+        RB_NON_MOVEABLE(frame_decoder);
+
+        explicit frame_decoder(context*);
+        ~frame_decoder();
+
+        static void* operator new(size_t, context*);
+        static void operator delete(void*, context*);
+        static void operator delete(void*);
+
+        device_id get_mirror() const {
+            return m_mirror;
+        }
+
+        // false if the frame is malformed or its baseline wasn't received
+        bool decode(const uint8_t*, size_t, frame_sequence&);
+    private:
+        struct entry {
+            bool m_valid;
+            frame_sequence m_sequence;
+            input_frame m_frame;
+        };
+
+        void apply(const input_frame&);
+
+        context* m_ctx;
+        device_id m_mirror;
+        bool m_has_applied;
+        frame_sequence m_applied;
+        std::array<entry, frame_history_size> m_history;
+    };
+}
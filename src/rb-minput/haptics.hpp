@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "api_types.hpp"
+
+namespace multi_input {
+    // single point of a rumble timeline, values are linearly
+    // interpolated between consecutive keyframes
+    struct haptics_keyframe {
+        api_int m_time;
+        api_float m_left;
+        api_float m_right;
+    };
+
+    static_assert(std::is_pod<haptics_keyframe>::value, "haptics_keyframe must be a POD");
+
+    using haptics_timeline = std::vector<haptics_keyframe>;
+
+    constexpr size_t max_haptics_keyframes = 256;
+
+    // where the timelines of one device go, unlike the device itself it may
+    // be used from any thread and outlive the device, play then fails
+    struct haptics_target {
+        virtual ~haptics_target() {
+        }
+
+        // an empty timeline stops whatever is playing
+        virtual bool play(haptics_timeline) = 0;
+    };
+
+    // returns false once the timeline is over
+    inline bool sample_timeline(const haptics_timeline& timeline, int time, float& left, float& right) {
+        if (timeline.empty() || time > timeline.back().m_time) {
+            left = right = 0;
+            return false;
+        }
+
+        auto prev = &timeline.front();
+        if (time <= prev->m_time) {
+            left = prev->m_left;
+            right = prev->m_right;
+            return true;
+        }
+
+        for (auto&& next : timeline) {
+            if (next.m_time < time) {
+                prev = &next;
+                continue;
+            }
+
+            auto span = next.m_time - prev->m_time;
+            auto t = span > 0 ? static_cast<float>(time - prev->m_time) / span : 1.0f;
+
+            left = prev->m_left + (next.m_left - prev->m_left) * t;
+            right = prev->m_right + (next.m_right - prev->m_right) * t;
+            return true;
+        }
+
+        left = prev->m_left;
+        right = prev->m_right;
+        return true;
+    }
+}
@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#include <algorithm>
+#include <cstring>
+
+#include "input_history.hpp"
+#include "device.hpp"
+#include "context.hpp"
+
+namespace multi_input {
+    namespace {
+        bool has_analog(const device_snapshot& snapshot, size_t slot) {
+            return (snapshot.m_analog_present & (uint32_t{1} << slot)) != 0;
+        }
+
+        // analog values compare bitwise, so -0 and NaN changes aren't lost
+        bool same_state(const device_snapshot& a, const device_snapshot& b) {
+            return a.m_digital_present == b.m_digital_present
+                && a.m_digital == b.m_digital
+                && a.m_analog_present == b.m_analog_present
+                && std::memcmp(a.m_analog.data(), b.m_analog.data(), sizeof(a.m_analog)) == 0;
+        }
+    }
+
+    bool device_snapshot::get(input_code code, float& value) const {
+        auto digital = to_digital_slot(code);
+        if (digital != no_digital_slot) {
+            if (!digital_channels::test(m_digital_present, digital)) {
+                return false;
+            }
+
+            value = digital_channels::test(m_digital, digital) ? 1.0f : 0.0f;
+            return true;
+        }
+
+        auto analog = to_analog_slot(code);
+        if (analog == no_analog_slot || !has_analog(*this, analog)) {
+            return false;
+        }
+
+        value = m_analog[analog];
+        return true;
+    }
+
+    size_t frame_view::get_device_count() const {
+        return m_devices != nullptr ? m_devices->size() : 0;
+    }
+
+    device_id frame_view::get_device(size_t index) const {
+        return (*m_devices)[index]->m_device;
+    }
+
+    const device_snapshot* frame_view::find(device_id id) const {
+        if (m_devices == nullptr) {
+            return nullptr;
+        }
+
+        auto it = std::lower_bound(m_devices->begin(), m_devices->end(), id, [](const snapshot_ptr& snapshot, device_id value) {
+            return snapshot->m_device < value;
+        });
+        if (it == m_devices->end() || (*it)->m_device != id) {
+            return nullptr;
+        }
+
+        return it->get();
+    }
+
+    input_history::input_history(memory_pool& memory) :
+        m_memory(&memory), m_frames(), m_next(0), m_count(0), m_latest()
+    {
+    }
+
+    void input_history::set_capacity(size_t capacity) {
+        m_frames.clear();
+        m_frames.resize(capacity);
+        m_count = 0;
+        m_latest.clear();
+    }
+
+    void input_history::record(context& ctx) {
+        if (m_frames.empty()) {
+            return;
+        }
+
+        // the overwritten frame releases its blocks, the device list keeps its capacity
+        auto&& entry = m_frames[m_next % m_frames.size()];
+        entry.m_frame = m_next;
+        entry.m_devices.clear();
+
+        ctx.for_each_device([&](device& dev) {
+            entry.m_devices.push_back(capture(dev));
+        });
+
+        std::sort(entry.m_devices.begin(), entry.m_devices.end(), [](const snapshot_ptr& a, const snapshot_ptr& b) {
+            return a->m_device < b->m_device;
+        });
+
+        ++m_next;
+        m_count = std::min(m_count + 1, m_frames.size());
+    }
+
+    void input_history::remove_device(device_id id) {
+        // recorded frames keep their blocks, the device existed back then
+        m_latest.erase(id);
+    }
+
+    frame_view input_history::get(frame_number frame) const {
+        if (m_count == 0 || frame < get_oldest() || frame > get_newest()) {
+            return frame_view{};
+        }
+
+        auto&& entry = m_frames[frame % m_frames.size()];
+        return frame_view{entry.m_frame, &entry.m_devices};
+    }
+
+    input_history::snapshot_ptr input_history::capture(device& dev) {
+        device_snapshot state{};
+        state.m_device = dev.get_id();
+
+        auto&& digital = dev.get_digital();
+        state.m_digital_present = digital.present();
+        state.m_digital = digital.held();
+
+        for (size_t slot = 0; slot < analog_code_count; ++slot) {
+            auto axis = dev.get_axis(from_analog_slot(slot));
+
+            if (axis != nullptr) {
+                state.m_analog_present |= uint32_t{1} << slot;
+                state.m_analog[slot] = axis->get();
+            }
+        }
+
+        auto it = m_latest.find(state.m_device);
+        if (it != m_latest.end() && same_state(*it->second, state)) {
+            return it->second;
+        }
+
+        auto block = std::allocate_shared<device_snapshot>(pool_allocator<device_snapshot>{*m_memory}, state);
+
+        if (it != m_latest.end()) {
+            it->second = block;
+        } else {
+            m_latest.emplace(state.m_device, block);
+        }
+
+        return block;
+    }
+}
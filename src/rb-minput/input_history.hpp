@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "utils.hpp"
+#include "api_types.hpp"
+#include "input_code.hpp"
+#include "digital_channels.hpp"
+#include "memory.hpp"
+
+namespace multi_input {
+    struct context;
+    struct device;
+
+    static_assert(analog_code_count <= 32, "analog presence must fit 32 bits");
+
+    // committed state of one device, immutable once recorded
+    // consecutive frames share the same block while the device doesn't change
+    struct device_snapshot {
+        device_id m_device;
+        digital_bits m_digital_present;
+        digital_bits m_digital;
+        uint32_t m_analog_present;
+        std::array<float, analog_code_count> m_analog;
+
+        // false if the device doesn't have the code
+        bool get(input_code, float&) const;
+    };
+
+    // state of every device at one commit
+    struct frame_view {
+        RB_COPYABLE(frame_view);
+
+        frame_view() : m_frame(0), m_devices(nullptr) {}
+
+        explicit operator bool() const {
+            return m_devices != nullptr;
+        }
+
+        frame_number get_frame() const {
+            return m_frame;
+        }
+
+        size_t get_device_count() const;
+        device_id get_device(size_t) const;
+        // nullptr if the device didn't exist at that frame
+        const device_snapshot* find(device_id) const;
+    private:
+        friend struct input_history;
+
+        using snapshot_ptr = std::shared_ptr<const device_snapshot>;
+
+        frame_view(frame_number frame, const std::vector<snapshot_ptr>* devices) : m_frame(frame), m_devices(devices) {}
+
+        frame_number m_frame;
+        const std::vector<snapshot_ptr>* m_devices;
+    };
+
+    // fixed-capacity ring of the last frames, slot = frame % capacity
+    // each commit records one frame, so one per drain_events or one per slice
+    // when slicing, a capacity of 0 disables recording
+    struct input_history {
+        RB_MOVEABLE(input_history);
+
+        explicit input_history(memory_pool&);
+
+        // drops everything recorded so far
+        void set_capacity(size_t);
+
+        size_t get_capacity() const {
+            return m_frames.size();
+        }
+
+        void record(context&);
+        void remove_device(device_id);
+
+        bool empty() const {
+            return m_count == 0;
+        }
+
+        frame_number get_oldest() const {
+            return m_next - m_count;
+        }
+
+        frame_number get_newest() const {
+            return m_next - 1;
+        }
+
+        // an empty view if the frame was never recorded or is already overwritten
+        frame_view get(frame_number) const;
+    private:
+        using snapshot_ptr = std::shared_ptr<const device_snapshot>;
+
+        struct frame_entry {
+            frame_number m_frame;
+            // sorted by device id
+            std::vector<snapshot_ptr> m_devices;
+        };
+
+        snapshot_ptr capture(device&);
+
+        memory_pool* m_memory;
+        std::vector<frame_entry> m_frames;
+        frame_number m_next;
+        size_t m_count;
+        // the newest block of every live device, reused while it's unchanged
+        std::unordered_map<device_id, snapshot_ptr> m_latest;
+    };
+}
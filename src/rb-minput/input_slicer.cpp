@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#include <algorithm>
+
+#include "input_slicer.hpp"
+#include "context.hpp"
+#include "latency.hpp"
+
+namespace multi_input {
+    void input_slicer::split(context& ctx, event_time start, event_time end, size_t count) {
+        m_changes.clear();
+        m_position = 0;
+        m_next = 0;
+        m_count = std::max(count, size_t{1});
+
+        if (end == 0) {
+            end = steady_now();
+        }
+
+        auto oldest = end;
+
+        ctx.for_each_device([&](device& dev) {
+            m_scratch.clear();
+            dev.take_changes(m_scratch);
+
+            for (auto&& change : m_scratch) {
+                m_changes.push_back(sliced_change{dev.get_id(), 0, change});
+                oldest = std::min(oldest, change.m_time);
+            }
+        });
+
+        if (start == 0) {
+            start = m_end != 0 ? m_end : oldest;
+        }
+
+        m_end = end;
+
+        auto length = end > start ? end - start : 0;
+        auto previous_device = device_id{0};
+        size_t previous_slice = 0;
+
+        for (auto&& entry : m_changes) {
+            auto time = entry.m_change.m_time;
+            size_t slice = 0;
+
+            if (time >= end) {
+                slice = m_count;
+            } else if (time > start && length > 0) {
+                slice = static_cast<size_t>((time - start) * m_count / length);
+            }
+
+            // a device's changes keep their order even if its timestamps don't
+            if (entry.m_device == previous_device) {
+                slice = std::max(slice, previous_slice);
+            }
+
+            entry.m_slice = slice;
+            previous_device = entry.m_device;
+            previous_slice = slice;
+        }
+
+        std::stable_sort(m_changes.begin(), m_changes.end(), [](const sliced_change& a, const sliced_change& b) {
+            return a.m_slice < b.m_slice;
+        });
+    }
+
+    bool input_slicer::apply_next(context& ctx) {
+        if (m_next >= m_count) {
+            return false;
+        }
+
+        apply_until(ctx, m_next);
+        ++m_next;
+        return true;
+    }
+
+    void input_slicer::flush(context& ctx) {
+        apply_until(ctx, m_count);
+
+        m_changes.clear();
+        m_position = 0;
+        m_next = m_count;
+    }
+
+    void input_slicer::apply_until(context& ctx, size_t slice) {
+        device* dev = nullptr;
+        auto id = device_id{0};
+
+        for (; m_position < m_changes.size() && m_changes[m_position].m_slice <= slice; ++m_position) {
+            auto&& entry = m_changes[m_position];
+
+            // devices removed since the split are skipped
+            if (dev == nullptr || entry.m_device != id) {
+                id = entry.m_device;
+                dev = ctx.get_device(id);
+            }
+
+            if (dev != nullptr) {
+                dev->apply_change(entry.m_change);
+            }
+        }
+    }
+}
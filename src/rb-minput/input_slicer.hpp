@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include <vector>
+
+#include "utils.hpp"
+#include "api_types.hpp"
+#include "device.hpp"
+
+namespace multi_input {
+    struct context;
+
+    // splits the drained, uncommitted changes of all devices into time slices
+    // so several fixed steps per rendered frame each see their own interval
+    // the changes are taken out of the devices once and applied back slice by
+    // slice, the context commits after each one
+    struct input_slicer {
+        RB_MOVEABLE(input_slicer);
+
+        input_slicer() : m_changes(), m_scratch(), m_position(0), m_next(0), m_count(0), m_end(0) {}
+
+        // slice i covers [start + i * length, start + (i + 1) * length), earlier
+        // changes go to the first slice and changes from end on stay uncommitted
+        // a start of 0 continues from the end of the previous split and an end
+        // of 0 is now
+        void split(context&, event_time start, event_time end, size_t count);
+
+        // applies the changes of the next slice, false once all were applied
+        bool apply_next(context&);
+
+        // applies everything left without committing, the next drain picks it up
+        void flush(context&);
+
+        size_t get_remaining() const {
+            return m_count - m_next;
+        }
+    private:
+        struct sliced_change {
+            device_id m_device;
+            size_t m_slice;
+            input_change m_change;
+        };
+
+        void apply_until(context&, size_t slice);
+
+        std::vector<sliced_change> m_changes;
+        std::vector<input_change> m_scratch;
+        size_t m_position;
+        size_t m_next;
+        size_t m_count;
+        event_time m_end;
+    };
+}
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "latency.hpp"
+
+namespace multi_input {
+    namespace {
+        size_t bucket_of(event_time latency) {
+            size_t bucket = 0;
+
+            while (latency > 1 && bucket + 1 < latency_bucket_count) {
+                latency >>= 1;
+                ++bucket;
+            }
+
+            return bucket;
+        }
+    }
+
+    event_time steady_now() {
+        return static_cast<event_time>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count());
+    }
+
+    latency_tracker::latency_tracker() :
+        m_pending(), m_pending_count(0),
+        m_buckets(), m_sample_count(0), m_latency_min(0), m_latency_max(0), m_latency_sum(0),
+        m_report_count(0), m_last_report(0), m_interval_count(0), m_interval_mean(0), m_interval_m2(0),
+        m_overflow_count(0), m_resync_count(0)
+    {
+    }
+
+    void latency_tracker::record_report(event_time time) {
+        if (m_report_count > 0 && time > m_last_report && time - m_last_report <= max_report_interval) {
+            // Welford's running mean and variance
+            auto interval = static_cast<double>(time - m_last_report);
+            ++m_interval_count;
+
+            auto delta = interval - m_interval_mean;
+            m_interval_mean += delta / static_cast<double>(m_interval_count);
+            m_interval_m2 += delta * (interval - m_interval_mean);
+        }
+
+        ++m_report_count;
+        m_last_report = time;
+
+        if (m_pending_count < max_pending) {
+            m_pending[m_pending_count++] = time;
+        }
+    }
+
+    void latency_tracker::publish(event_time visible) {
+        for (size_t idx = 0; idx < m_pending_count; ++idx) {
+            // timestamps from the future mean a clock mismatch, count them as immediate
+            auto time = m_pending[idx];
+            auto latency = visible > time ? visible - time : 0;
+
+            if (m_sample_count == 0) {
+                m_latency_min = latency;
+                m_latency_max = latency;
+            } else {
+                m_latency_min = std::min(m_latency_min, latency);
+                m_latency_max = std::max(m_latency_max, latency);
+            }
+
+            ++m_sample_count;
+            ++m_buckets[bucket_of(latency)];
+            m_latency_sum += static_cast<double>(latency);
+        }
+
+        m_pending_count = 0;
+    }
+
+    void latency_tracker::record_overflow() {
+        ++m_overflow_count;
+    }
+
+    void latency_tracker::record_resync() {
+        ++m_resync_count;
+    }
+
+    void latency_tracker::reset() {
+        *this = latency_tracker{};
+    }
+
+    void latency_tracker::get_stats(latency_stats& stats) const {
+        stats = latency_stats{};
+
+        stats.m_sample_count = m_sample_count;
+        std::copy(m_buckets.begin(), m_buckets.end(), stats.m_buckets);
+
+        if (m_sample_count > 0) {
+            stats.m_latency_min = static_cast<api_float>(m_latency_min);
+            stats.m_latency_max = static_cast<api_float>(m_latency_max);
+            stats.m_latency_mean = static_cast<api_float>(m_latency_sum / static_cast<double>(m_sample_count));
+        }
+
+        stats.m_report_count = m_report_count;
+
+        if (m_interval_count > 0 && m_interval_mean > 0) {
+            stats.m_interval_mean = static_cast<api_float>(m_interval_mean);
+            stats.m_report_rate = static_cast<api_float>(1000000.0 / m_interval_mean);
+            stats.m_jitter = static_cast<api_float>(std::sqrt(m_interval_m2 / static_cast<double>(m_interval_count)));
+        }
+
+        stats.m_overflow_count = m_overflow_count;
+        stats.m_resync_count = m_resync_count;
+    }
+}
@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "utils.hpp"
+#include "api_types.hpp"
+
+namespace multi_input {
+    // the clock all event timestamps are converted to
+    event_time steady_now();
+
+    constexpr size_t latency_bucket_count = 20;
+
+    // bucket n counts latencies in [2^n, 2^(n+1)) microseconds,
+    // the first bucket also takes 0 and the last one everything above
+    // all times are in microseconds
+    struct latency_stats {
+        uint64_t m_sample_count;
+        uint64_t m_buckets[latency_bucket_count];
+        api_float m_latency_min;
+        api_float m_latency_max;
+        api_float m_latency_mean;
+
+        uint64_t m_report_count;
+        api_float m_report_rate;
+        api_float m_interval_mean;
+        api_float m_jitter;
+
+        // reports the device lost to a full kernel buffer and how many times
+        // its whole state was read back afterwards, 0 where that can't happen
+        uint64_t m_overflow_count;
+        uint64_t m_resync_count;
+    };
+
+    static_assert(std::is_pod<latency_stats>::value, "latency_stats must be a POD");
+
+    // measures the time from the timestamp of a device report (kernel or
+    // X server) until drain_events makes it visible, plus the report rate
+    // and its jitter (standard deviation of the interval between reports)
+    struct latency_tracker {
+        RB_COPYABLE(latency_tracker);
+
+        latency_tracker();
+
+        // report timestamps must be on the steady_now clock
+        void record_report(event_time);
+        void publish(event_time);
+        void record_overflow();
+        void record_resync();
+        void reset();
+
+        void get_stats(latency_stats&) const;
+    private:
+        // at most this many reports per drain contribute latency samples
+        static constexpr size_t max_pending = 64;
+        // longer gaps mean the device was idle, not slow
+        static constexpr event_time max_report_interval = 100000;
+
+        std::array<event_time, max_pending> m_pending;
+        size_t m_pending_count;
+
+        std::array<uint64_t, latency_bucket_count> m_buckets;
+        uint64_t m_sample_count;
+        event_time m_latency_min;
+        event_time m_latency_max;
+        double m_latency_sum;
+
+        uint64_t m_report_count;
+        event_time m_last_report;
+        uint64_t m_interval_count;
+        double m_interval_mean;
+        double m_interval_m2;
+
+        uint64_t m_overflow_count;
+        uint64_t m_resync_count;
+    };
+}
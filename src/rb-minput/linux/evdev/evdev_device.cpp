@@ -5,7 +5,12 @@
 
 #include <sys/ioctl.h>
 
+#include <limits>
+#include <algorithm>
+#include <cassert>
+
 #include "linux/evdev/evdev_device.hpp"
+#include "linux/evdev/haptics_scheduler.hpp"
 #include "device.hpp"
 #include "context.hpp"
 #include "input_code.hpp"
@@ -15,12 +20,22 @@ namespace multi_input {
     namespace lnx {
         // TODO non xbox
 
-        evdev_device::evdev_device(context* ctx, device_id id, evdev_handle&& handle) :
+        evdev_device::evdev_device(context* ctx, device_id id, evdev_handle&& handle, haptics_scheduler& haptics) :
             device(ctx, id),
-            m_handle(std::move(handle)), m_can_vibrate(), m_last_effect(-1)
+            m_handle(std::move(handle)), m_can_vibrate(), m_kernel_clock(), m_ff(), m_haptics(),
+            m_slots(), m_key_slots(), m_abs_slots(), m_buffer(), m_buffer_begin(0), m_buffer_end(0), m_frame(), m_dropped(false)
         {
             auto handle_raw = m_handle.get();
 
+            // EVIOCSCLOCKID through libevdev, so its synthesized events use the same clock
+            // CLOCK_MONOTONIC is what steady_now uses, which makes latency measurable
+            auto rc = libevdev_set_clock_id(handle_raw, CLOCK_MONOTONIC);
+            m_kernel_clock = rc == 0;
+
+            if (!m_kernel_clock) {
+                m_ctx->log_warning(u8"evdev: #%1% can't use CLOCK_MONOTONIC timestamps (%2%), falling back to drain time", m_id, -rc);
+            }
+
             auto& meta = get_meta();
             meta.set_name(libevdev_get_name(handle_raw));
             meta.set_location(libevdev_get_phys(handle_raw));
@@ -76,6 +91,17 @@ namespace multi_input {
 
             // TODO maybe other force-feedback types?
             m_can_vibrate = libevdev_has_event_code(m_handle.get(), EV_FF, FF_RUMBLE);
+
+            if (m_can_vibrate) {
+                m_ff = std::make_shared<ff_effect_cache>(m_ctx, m_id, m_handle.get_fd());
+                m_can_vibrate = m_ff->get_channel_count() > 0;
+
+                if (m_ff->has_haptics_channel()) {
+                    m_haptics = haptics.make_target(m_ff);
+                } else if (m_can_vibrate) {
+                    m_ctx->log_debug(u8"evdev: device %1% has a single FF slot, haptics timelines are not supported", m_id);
+                }
+            }
         }
 
         evdev_device::~evdev_device() {
@@ -94,28 +120,213 @@ namespace multi_input {
                 return false;
             } else {
                 auto axis_code = event_type == EV_KEY ? map_button_code(event_code) : map_axis_code(event_code);
-                add_axis(axis_code);
+                add_slot(event_type, event_code, add_axis(axis_code));
                 return true;
             }
         }
 
-        void evdev_device::update(const input_event& event) {
-            m_ctx->log_verbose(
-                "evdev: device %1% event %2% code %3% value %4%",
-                m_id,
-                libevdev_event_type_get_name(event.type),
-                libevdev_event_code_get_name(event.type, event.code),
-                event.value
-            );
+        void evdev_device::add_slot(unsigned event_type, unsigned event_code, axis_ref axis) {
+            auto& index = event_type == EV_KEY ? m_key_slots[event_code] : m_abs_slots[event_code];
+            if (axis == nullptr || index != 0 || m_slots.size() >= std::numeric_limits<slot_index>::max()) {
+                return;
+            }
+
+            code_slot slot{axis, event_code, event_type == EV_KEY, false, 0.0f, 0.0f, 0.0f};
+
+            if (event_type == EV_ABS) {
+                // reverse Y axis
+                slot.m_invert = event_code == ABS_Y || event_code == ABS_RY;
+                slot.m_minimum = static_cast<float>(libevdev_get_abs_minimum(m_handle.get(), event_code));
+                slot.m_maximum = static_cast<float>(libevdev_get_abs_maximum(m_handle.get(), event_code));
+                slot.m_deadzone = get_deadzone_for(event_code);
+            }
+
+            m_slots.push_back(slot);
+            index = static_cast<slot_index>(m_slots.size());
+        }
+
+        int evdev_device::read_events(size_t limit, size_t& read) {
+            m_ctx->log_verbose("evdev: device %1% fd ready", m_id);
+
+            read = 0;
+
+            while (true) {
+                if (m_buffer_begin == m_buffer_end) {
+                    auto length = ::read(m_handle.get_fd(), m_buffer.data(), sizeof(m_buffer));
+
+                    if (length < 0 && errno == EINTR) {
+                        continue;
+                    } else if (length < 0) {
+                        return errno == EAGAIN ? 0 : -errno;
+                    } else if (length == 0) {
+                        return 0;
+                    }
+
+                    // the kernel only hands out whole events
+                    m_buffer_begin = 0;
+                    m_buffer_end = static_cast<size_t>(length) / sizeof(input_event);
+                }
+
+                auto rc = consume(limit, read);
+                if (rc != 0) {
+                    return rc;
+                }
+            }
+        }
+
+        void evdev_device::fill(const input_event* events, size_t count) {
+            assert(m_buffer_begin == m_buffer_end && count <= m_buffer.size());
+
+            std::copy(events, events + count, m_buffer.begin());
+            m_buffer_begin = 0;
+            m_buffer_end = count;
+        }
+
+        int evdev_device::consume(size_t limit, size_t& read) {
+            while (m_buffer_begin < m_buffer_end) {
+                auto& event = m_buffer[m_buffer_begin++];
+                ++read;
+
+                if (event.type != EV_SYN) {
+                    if (!m_dropped) {
+                        m_frame.push_back(event);
+                    }
+                    continue;
+                }
+
+                if (event.code == SYN_DROPPED) {
+                    // the kernel buffer overflowed, the rest of the report is incomplete
+                    if (!m_dropped) {
+                        m_ctx->log_debug(u8"evdev: device %1% dropped events, resynchronizing", m_id);
+                        m_latency.record_overflow();
+                    }
+
+                    m_frame.clear();
+                    m_dropped = true;
+                    continue;
+                } else if (event.code != SYN_REPORT) {
+                    continue;
+                }
+
+                auto time = m_kernel_clock
+                    ? static_cast<event_time>(event.time.tv_sec) * 1000000 + static_cast<event_time>(event.time.tv_usec)
+                    : m_digital.get_time();
+
+                if (m_dropped) {
+                    // the state is read back once the kernel has a complete report again
+                    m_dropped = false;
+
+                    auto rc = resync(time);
+                    if (rc < 0) {
+                        return rc;
+                    }
+                } else {
+                    apply_frame(time);
+                }
+
+                if (read >= limit) {
+                    return 1;
+                }
+            }
+
+            return 0;
+        }
+
+        void evdev_device::apply_frame(event_time time) {
+            m_ctx->log_verbose("evdev: device %1% report of %2% events", m_id, m_frame.size());
+
+            if (m_kernel_clock) {
+                set_event_time(time);
+                m_latency.record_report(time);
+            }
+
+            for (auto&& event : m_frame) {
+                slot_index index = 0;
+
+                if (event.type == EV_KEY && event.code < KEY_CNT) {
+                    index = m_key_slots[event.code];
+                } else if (event.type == EV_ABS && event.code < ABS_CNT) {
+                    index = m_abs_slots[event.code];
+                } else {
+                    continue;
+                }
+
+                if (index == 0) {
+                    index = add_undiscovered(event.type, event.code);
+                    if (index == 0) {
+                        continue;
+                    }
+                }
+
+                set_slot(m_slots[index - 1], time, event.value);
+            }
+
+            m_frame.clear();
+        }
+
+        int evdev_device::resync(event_time time) {
+            constexpr size_t bits_per_word = sizeof(unsigned long) * 8;
+            std::array<unsigned long, (KEY_CNT + bits_per_word - 1) / bits_per_word> keys{};
+
+            auto fd = m_handle.get_fd();
+
+            // replaying the sync events libevdev would synthesize costs a
+            // call per code, the bitmask covers every button at once
+            if (ioctl(fd, EVIOCGKEY(sizeof(keys)), keys.data()) < 0) {
+                auto rc = -errno;
+                m_ctx->log_warning(u8"evdev: device %1% failed to read button state: %2%", m_id, posix_error_message(rc));
+                return rc;
+            }
 
-            switch (event.type) {
-                case EV_KEY:
-                    update_button(event.code, event.value);
-                    break;
-                case EV_ABS:
-                    update_axis(event.code, event.value);
-                    break;
+            if (m_kernel_clock) {
+                set_event_time(time);
             }
+
+            for (auto&& slot : m_slots) {
+                if (slot.m_button) {
+                    auto pressed = (keys[slot.m_code / bits_per_word] >> (slot.m_code % bits_per_word)) & 1;
+                    set_slot(slot, time, static_cast<int>(pressed));
+                    continue;
+                }
+
+                input_absinfo info{};
+                if (ioctl(fd, EVIOCGABS(slot.m_code), &info) < 0) {
+                    auto rc = -errno;
+                    m_ctx->log_warning(u8"evdev: device %1% failed to read axis %2% state: %3%", m_id, slot.m_code, posix_error_message(rc));
+                    return rc;
+                }
+
+                set_slot(slot, time, info.value);
+            }
+
+            m_latency.record_resync();
+            return 0;
+        }
+
+        void evdev_device::set_slot(code_slot& slot, event_time time, int value) {
+            slot.m_axis.set_time(time);
+
+            if (slot.m_button) {
+                slot.m_axis.set(value != 0 ? 1.0f : 0.0f);
+            } else {
+                slot.m_axis.set(map_value(slot, static_cast<float>(value)));
+            }
+        }
+
+        evdev_device::slot_index evdev_device::add_undiscovered(unsigned event_type, unsigned event_code) {
+            auto axis_code = event_type == EV_KEY ? map_button_code(event_code) : map_axis_code(event_code);
+
+            if (axis_code == input_code::none) {
+                return 0;
+            }
+
+            m_ctx->log_warning(
+                u8"evdev: possible bug: got %1% code %2% (mapped %3%) but it wasn't added during discovery",
+                event_type == EV_KEY ? u8"button" : u8"axis", event_code, static_cast<int>(axis_code)
+            );
+
+            add_slot(event_type, event_code, add_axis(axis_code));
+            return event_type == EV_KEY ? m_key_slots[event_code] : m_abs_slots[event_code];
         }
 
         input_code evdev_device::map_button_code(unsigned code) {
@@ -150,57 +361,6 @@ namespace multi_input {
             }
         }
 
-        void evdev_device::update_button(unsigned code, int value) {
-            auto axis_code = map_button_code(code);
-            auto axis = get_axis(axis_code);
-
-            if (axis_code == input_code::none) {
-                return;
-            }
-
-            if (axis == nullptr) {
-                m_ctx->log_warning(
-                    u8"evdev: possible bug: got button code %1% (mapped %2%) but it wasn't added during discovery",
-                    code, static_cast<int>(axis_code)
-                );
-                axis = add_axis(axis_code);
-            }
-
-            m_ctx->log_verbose(
-                u8"evdev: %1%: axis %2% device %3%",
-                value != 0 ? u8"button press" : u8"button release",
-                static_cast<int>(axis_code), m_id
-            );
-
-            axis->set(value != 0 ? 1.0f : 0.0f);
-        }
-
-        void evdev_device::update_axis(unsigned code, int raw_value) {
-            auto axis_code = map_axis_code(code);
-            auto axis = get_axis(axis_code);
-
-            if (axis_code == input_code::none) {
-                return;
-            }
-
-            if (axis == nullptr) {
-                m_ctx->log_warning(
-                    u8"evdev: possible bug: got axis code %1% (mapped %2%) but it wasn't added during discovery",
-                    code, static_cast<int>(axis_code)
-                );
-                axis = add_axis(axis_code);
-            }
-
-            auto value = map_value(code, raw_value);
-
-            m_ctx->log_verbose(
-                u8"evdev: axis %1% value %2% (mapped %3%) device %4%",
-                static_cast<int>(axis_code), raw_value, value, m_id
-            );
-
-            axis->set(value);
-        }
-
         // TODO non xbox, unify platforms
         float evdev_device::get_deadzone_for(unsigned code) {
             switch (code) {
@@ -218,21 +378,16 @@ namespace multi_input {
             }
         }
 
-        float evdev_device::map_value(unsigned code, float raw_value) {
-            // reverse Y axis
-            if (code == ABS_Y || code == ABS_RY) {
+        float evdev_device::map_value(const code_slot& slot, float raw_value) {
+            if (slot.m_invert) {
                 raw_value = -raw_value;
             }
 
             // TODO configurable deadzones
-            auto deadzone = get_deadzone_for(code);
-
             if (raw_value < 0) {
-                auto abs_max = -libevdev_get_abs_minimum(m_handle.get(), code);
-                return -apply_deadzone(-raw_value, abs_max, deadzone);
+                return -apply_deadzone(-raw_value, -slot.m_minimum, slot.m_deadzone);
             } else {
-                auto abs_max = libevdev_get_abs_maximum(m_handle.get(), code);
-                return apply_deadzone(raw_value, abs_max, deadzone);
+                return apply_deadzone(raw_value, slot.m_maximum, slot.m_deadzone);
             }
         }
 
@@ -287,46 +442,13 @@ namespace multi_input {
                 return false;
             }
 
-            int fd = get_handle().get_fd();
-            m_ctx->log_debug("evdev: vibrating device %1% with force %2%/%3% for %4%ms", m_id, left, right, duration);
-
-            if (m_last_effect != -1) {
-                RB_TRACE("removing previous FF effect");
-                m_ctx->log_debug("evdev: removing previous FF effect from device memory: %1%", m_last_effect);
-
-                if (ioctl(fd, EVIOCRMFF, m_last_effect) == -1) {
-                   throw_posix_error("evdev: failed to remove FF effect %1% from device fd %2%", m_last_effect, fd);
-                }
-
-                m_last_effect = -1;
-            }
-
-            RB_TRACE("creating new FF effect");
+            m_ctx->log_verbose("evdev: vibrating device %1% with force %2%/%3% for %4%ms", m_id, left, right, duration);
 
-            ff_effect effect{};
-            effect.type = FF_RUMBLE;
-            effect.id = -1;
-            effect.replay.length = duration;
-            effect.u.rumble.strong_magnitude = static_cast<unsigned short>(left * 16384);
-            effect.u.rumble.weak_magnitude = static_cast<unsigned short>(right * 65535);
-
-            if (ioctl(fd, EVIOCSFF, &effect) == -1) {
-                throw_posix_error("evdev: failed to upload new FF effect to device fd %1%", fd);
-            }
-
-            m_last_effect = effect.id;
-            m_ctx->log_debug("evdev: created new FF_RUMBLE effect with id %1%", m_last_effect);
-
-            input_event play{};
-            play.type = EV_FF;
-            play.code = m_last_effect;
-            play.value = 3;
-
-            if (write(fd, static_cast<const void*>(&play), sizeof(play)) == -1) {
-                throw_posix_error("evdev: failed to start FF effect %1% on device fd %2%", m_last_effect, fd);
-            }
+            return m_ff->play(ff_effect_cache::vibrate_channel, make_rumble(left, right, duration));
+        }
 
-            return true;
+        std::shared_ptr<haptics_target> evdev_device::get_haptics_target() {
+            return m_haptics;
         }
 
         void evdev_device::commit() {
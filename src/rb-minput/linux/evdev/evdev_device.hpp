@@ -3,23 +3,48 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+#include <linux/input.h>
+
 #include "device.hpp"
 #include "utils.hpp"
 #include "linux/evdev/evdev_handle.hpp"
-
-struct input_event;
+#include "linux/evdev/evdev_ff.hpp"
 
 namespace multi_input {
     namespace lnx {
+        struct haptics_scheduler;
+
         struct evdev_device : device {
             RB_NON_MOVEABLE(evdev_device);
 
-            evdev_device(context*, device_id, evdev_handle&&);
+            // events taken from the kernel at once
+            static constexpr size_t read_capacity = 64;
+
+            evdev_device(context*, device_id, evdev_handle&&, haptics_scheduler&);
             virtual ~evdev_device();
 
-            void update(const input_event&);
+            // reads what the kernel queued straight from the fd, 0 once
+            // drained, 1 when the limit was reached or a negative errno, the
+            // reports read before a failure are kept
+            // after the kernel drops events the state is read back in one
+            // EVIOCGKEY and an EVIOCGABS per mapped axis
+            // events are applied a whole SYN_REPORT at a time, past the limit
+            // reading goes on up to the next one, so a report is never split
+            // between drains
+            int read_events(size_t limit, size_t& read);
+            // for reads done elsewhere (io_uring), only valid once consume
+            // has emptied the buffer
+            void fill(const input_event*, size_t);
+            // like read_events without touching the fd, 0 once the buffer is empty
+            int consume(size_t limit, size_t& read);
             void post_update();
             virtual bool vibrate(int, float, float) override;
+            virtual std::shared_ptr<haptics_target> get_haptics_target() override;
             virtual void commit() override;
 
             evdev_handle& get_handle() {
@@ -30,17 +55,53 @@ namespace multi_input {
                 return m_can_vibrate;
             }
         private:
+            // an evdev code resolved at discovery, a report applies without
+            // mapping switches or axis lookups
+            struct code_slot {
+                axis_ref m_axis;
+                unsigned m_code;
+                bool m_button;
+                bool m_invert;
+                float m_minimum;
+                float m_maximum;
+                float m_deadzone;
+            };
+
+            // index into m_slots plus one, 0 for codes we don't map
+            using slot_index = std::uint8_t;
+
             bool try_add_axis(unsigned, unsigned);
-            void update_button(unsigned, int);
-            void update_axis(unsigned, int);
+            void add_slot(unsigned, unsigned, axis_ref);
+            void apply_frame(event_time);
+            // reads the whole state back after an overflow, 0 or a negative errno
+            int resync(event_time);
+            void set_slot(code_slot&, event_time, int);
+            // adds what a report used without discovery having seen it
+            slot_index add_undiscovered(unsigned, unsigned);
             input_code map_button_code(unsigned);
             input_code map_axis_code(unsigned);
-            float map_value(unsigned, float);
+            float map_value(const code_slot&, float);
             float get_deadzone_for(unsigned);
 
             evdev_handle m_handle;
             bool m_can_vibrate;
-            short m_last_effect;
+            // kernel timestamps are on the steady_now clock
+            bool m_kernel_clock;
+            std::shared_ptr<ff_effect_cache> m_ff;
+            // null unless the device has a channel to spare for the worker
+            std::shared_ptr<haptics_target> m_haptics;
+            std::vector<code_slot> m_slots;
+            std::array<slot_index, KEY_CNT> m_key_slots;
+            std::array<slot_index, ABS_CNT> m_abs_slots;
+            // one read() worth of events, the ones past the report that hit
+            // the limit wait here for the next drain
+            std::array<input_event, read_capacity> m_buffer;
+            size_t m_buffer_begin;
+            size_t m_buffer_end;
+            // events of the report being read, applied on its SYN_REPORT
+            std::vector<input_event> m_frame;
+            // the kernel dropped events, everything up to the next SYN_REPORT is stale
+            bool m_dropped;
         };
     }
 }
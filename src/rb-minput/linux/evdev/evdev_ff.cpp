@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#include "linux/evdev/evdev.hpp"
+
+#include <algorithm>
+#include <sys/ioctl.h>
+
+#include "linux/evdev/evdev_ff.hpp"
+#include "context.hpp"
+
+namespace multi_input {
+    namespace lnx {
+        namespace {
+            // we never need more than a few layered effects per device
+            constexpr int max_channels = 4;
+
+            // repeat count used when starting an effect
+            constexpr int play_count = 3;
+        }
+
+        ff_effect_cache::ff_effect_cache(context* ctx, device_id id, int fd) :
+            m_ctx(ctx), m_id(id), m_fd(duplicate(fd)), m_mutex(), m_slots()
+        {
+            int capacity = 0;
+            if (ioctl(m_fd.get(), EVIOCGEFFECTS, &capacity) == -1) {
+                m_ctx->log_debug("evdev: EVIOCGEFFECTS failed on device %1%, assuming no FF slots", m_id);
+                capacity = 0;
+            }
+
+            auto channels = std::min(capacity, max_channels);
+            m_slots.resize(static_cast<size_t>(std::max(channels, 0)), slot{-1, ff_rumble{}, false, {}});
+
+            m_ctx->log_debug("evdev: device %1% has %2% FF slots, using %3% channels", m_id, capacity, m_slots.size());
+        }
+
+        bool ff_effect_cache::is_playing(const ff_effect_cache::slot& s, clock::time_point now) const {
+            if (!s.m_playing) {
+                return false;
+            }
+
+            if (s.m_effect.m_length == 0) {
+                // zero length effects play until stopped
+                return true;
+            }
+
+            auto length = std::chrono::milliseconds{s.m_effect.m_length * play_count};
+            return now < s.m_started + length;
+        }
+
+        bool ff_effect_cache::play(size_t channel, const ff_rumble& effect) {
+            RB_TRACE_ENTER();
+
+            if (channel >= m_slots.size()) {
+                RB_TRACE("no such channel");
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock{m_mutex};
+
+            auto now = clock::now();
+            auto&& s = m_slots[channel];
+            auto playing = is_playing(s, now);
+
+            if (effect.is_silent()) {
+                if (s.m_id != -1 && playing) {
+                    RB_TRACE("stopping effect");
+                    write_play(s, 0);
+                    s.m_playing = false;
+                }
+
+                return true;
+            }
+
+            if (s.m_id != -1 && s.m_effect == effect) {
+                if (playing && effect.m_length == 0) {
+                    RB_TRACE("skipping redundant request");
+                    return true;
+                }
+            } else {
+                RB_TRACE("uploading effect");
+                upload(s, effect);
+            }
+
+            RB_TRACE("starting effect");
+            write_play(s, play_count);
+            s.m_playing = true;
+            s.m_started = now;
+            return true;
+        }
+
+        void ff_effect_cache::upload(ff_effect_cache::slot& s, const ff_rumble& params) {
+            ff_effect effect{};
+            effect.type = FF_RUMBLE;
+            effect.id = s.m_id;
+            effect.replay.length = params.m_length;
+            effect.u.rumble.strong_magnitude = params.m_strong;
+            effect.u.rumble.weak_magnitude = params.m_weak;
+
+            if (ioctl(m_fd.get(), EVIOCSFF, &effect) == -1) {
+                if (s.m_id == -1) {
+                    throw_posix_error("evdev: failed to upload new FF effect to device fd %1%", m_fd.get());
+                }
+
+                // the device may have dropped the effect (e.g. after a reset)
+                // so try again with a freshly allocated slot
+                m_ctx->log_deferred(log_level::debug, "evdev: failed to update FF effect %1% on device %2% in place, uploading again", s.m_id, m_id);
+                s.m_id = -1;
+
+                effect.id = -1;
+                if (ioctl(m_fd.get(), EVIOCSFF, &effect) == -1) {
+                    throw_posix_error("evdev: failed to upload new FF effect to device fd %1%", m_fd.get());
+                }
+            }
+
+            if (s.m_id == -1) {
+                m_ctx->log_deferred(log_level::debug, "evdev: created new FF_RUMBLE effect with id %1% on device %2%", effect.id, m_id);
+            }
+
+            s.m_id = effect.id;
+            s.m_effect = params;
+        }
+
+        void ff_effect_cache::write_play(ff_effect_cache::slot& s, int value) {
+            input_event play{};
+            play.type = EV_FF;
+            play.code = s.m_id;
+            play.value = value;
+
+            if (write(m_fd.get(), static_cast<const void*>(&play), sizeof(play)) == -1) {
+                throw_posix_error("evdev: failed to play FF effect %1% (value %2%) on device fd %3%", s.m_id, value, m_fd.get());
+            }
+        }
+    }
+}
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <mutex>
+
+#include "linux/file_descriptor.hpp"
+#include "utils.hpp"
+#include "api_types.hpp"
+
+namespace multi_input {
+    struct context;
+
+    namespace lnx {
+        struct ff_rumble {
+            unsigned short m_strong;
+            unsigned short m_weak;
+            unsigned short m_length;
+
+            bool is_silent() const {
+                return m_strong == 0 && m_weak == 0;
+            }
+        };
+
+        inline ff_rumble make_rumble(float left, float right, int duration) {
+            ff_rumble effect{};
+            effect.m_strong = static_cast<unsigned short>(left * 16384);
+            effect.m_weak = static_cast<unsigned short>(right * 65535);
+            effect.m_length = static_cast<unsigned short>(duration);
+            return effect;
+        }
+
+        inline bool operator==(const ff_rumble& a, const ff_rumble& b) {
+            return a.m_strong == b.m_strong && a.m_weak == b.m_weak && a.m_length == b.m_length;
+        }
+
+        inline bool operator!=(const ff_rumble& a, const ff_rumble& b) {
+            return !(a == b);
+        }
+
+        // keeps FF_RUMBLE effects uploaded to the device between calls
+        // each channel owns one effect slot, there are never more channels than
+        // the device has slots: changed effects are updated in place
+        // with EVIOCSFF (reusing the effect id), unchanged ones are only restarted
+        // and redundant requests don't touch the device at all
+        // the kernel mixes rumble effects playing at the same time, so channels
+        // can be used to layer independent effects on a single device
+        // the cache keeps its own handle to the device, so it can be shared
+        // with the haptics worker thread and outlive the device object, play
+        // only logs through the deferred queue for the same reason
+        struct ff_effect_cache {
+            RB_NON_MOVEABLE(ff_effect_cache);
+
+            // vibrate and the haptics worker never share a channel, so
+            // neither overwrites or stops the other's effect
+            static constexpr size_t vibrate_channel = 0;
+            static constexpr size_t haptics_channel = 1;
+
+            ff_effect_cache(context*, device_id, int);
+
+            bool play(size_t, const ff_rumble&);
+
+            size_t get_channel_count() const {
+                return m_slots.size();
+            }
+
+            // devices with a single slot only support vibrate
+            bool has_haptics_channel() const {
+                return m_slots.size() > haptics_channel;
+            }
+        private:
+            using clock = std::chrono::steady_clock;
+
+            struct slot {
+                short m_id;
+                ff_rumble m_effect;
+                bool m_playing;
+                clock::time_point m_started;
+            };
+
+            bool is_playing(const slot&, clock::time_point) const;
+            void upload(slot&, const ff_rumble&);
+            void write_play(slot&, int);
+
+            context* m_ctx;
+            device_id m_id;
+            file_descriptor m_fd;
+            std::mutex m_mutex;
+            std::vector<slot> m_slots;
+        };
+    }
+}
@@ -12,27 +12,31 @@
 #include "linux/evdev/evdev_handle.hpp"
 #include "linux/evdev/evdev_device.hpp"
 #include "linux/evdev/evdev.hpp"
+#include "linux/evdev/uring_reader.hpp"
 #include "linux/udev_info.hpp"
+#include "linux/uevent_monitor.hpp"
 #include "linux/fs.hpp"
 #include "source.hpp"
 #include "context.hpp"
 
 namespace multi_input {
     namespace lnx {
+        namespace {
+            // events a device may read per turn while a budget is set, small
+            // enough that one busy device can't spend the budget of the others
+            constexpr size_t device_quantum = 64;
+        }
+
         evdev_source::evdev_source(context* ctx) :
-            source(ctx), m_device_map(), m_inotify(open_inotify()), m_inotify_udev(open_inotify()),
-            m_poller(), m_sysfs_base_path(fs::sysfs_path()), m_pending()
+            source(ctx), m_device_map(), m_monitor(uevent_monitor::create(ctx)), m_uevents(), m_hotplug(),
+            m_poller(), m_reader(uring_reader::create(ctx)), m_completions(), m_sysfs_base_path(fs::sysfs_path()), m_failures(), m_quarantined(),
+            m_ready(), m_backlog(), m_haptics(ctx)
         {
-            if (inotify_add_watch(m_inotify.get(), "/dev/input", IN_CREATE | IN_DELETE) < 0) {
-                throw_posix_error("Failed to add inotify watch on /dev/input");
-            }
-
-            if (inotify_add_watch(m_inotify_udev.get(), "/run/udev", IN_DELETE) < 0) {
-                throw_posix_error("Failed to add inotify watch on /run/udev");
+            if (m_monitor != nullptr) {
+                m_poller.add(m_monitor->get_fd(), m_monitor.get());
+            } else {
+                m_ctx->log_warning(u8"evdev: hotplug unavailable, devices are only found when enumerating");
             }
-
-            m_poller.add(m_inotify.get());
-            m_poller.add(m_inotify_udev.get());
         }
 
         evdev_source::~evdev_source() {
@@ -47,10 +51,17 @@ namespace multi_input {
             // so we can't tell here what changed
             // and therefore need to discard existing state
             for (auto&& pair : m_device_map) {
+                auto fd_ptr = m_device_map.id_to_fd(pair.second);
+                if (fd_ptr != nullptr) {
+                    release_device(pair.second, *fd_ptr);
+                }
+
                 m_ctx->remove_device(pair.second);
             }
 
             m_device_map.clear();
+            m_quarantined.clear();
+            m_backlog.clear();
 
             auto sysfs_devices = fs::list(m_sysfs_base_path);
             for (auto&& symbolic_name : sysfs_devices) {
@@ -98,9 +109,20 @@ namespace multi_input {
 
             RB_TRACE("creating new device object");
             auto id = m_ctx->get_next_id();
-            m_ctx->add_device(std::unique_ptr<device>{new evdev_device(m_ctx, id, std::move(handle))});
+            auto device_ptr = new (m_ctx) evdev_device(m_ctx, id, std::move(handle), m_haptics);
+            m_ctx->add_device(std::unique_ptr<device>{device_ptr});
             m_device_map.add(symbolic_name, fd, id);
-            m_poller.add(fd);
+
+            if (m_reader != nullptr) {
+                m_reader->post(*device_ptr);
+                m_reader->submit();
+                return;
+            }
+
+            m_poller.add(fd, device_ptr);
+
+            // whatever was queued before the registration raised no edge
+            m_backlog.push_back(device_ptr);
         }
 
         void evdev_source::remove_device(const std::string& symbolic_name) {
@@ -118,50 +140,87 @@ namespace multi_input {
             auto fd = *fd_ptr;
 
             RB_TRACE("removing device object");
-            m_poller.remove(fd);
+            release_device(id, fd);
+            drop_backlog(id);
+            m_quarantined.erase(id);
             m_ctx->remove_device(id);
-            m_device_map.remove(symbolic_name, fd, id);
+            m_device_map.remove(symbolic_name, id);
         }
 
-        evdev_device* evdev_source::get_device(int fd) {
-            RB_TRACE_ENTER();
+        void evdev_source::release_device(device_id id, int fd) {
+            auto device_ptr = static_cast<evdev_device*>(m_ctx->get_device(id));
 
-            auto id_ptr = m_device_map.fd_to_id(fd);
-            if (id_ptr == nullptr) {
-                RB_TRACE("unknown device: not in device map");
-                return nullptr;
+            if (m_reader != nullptr && device_ptr != nullptr) {
+                m_reader->cancel(*device_ptr);
             }
 
-            auto device_ptr = static_cast<evdev_device*>(m_ctx->get_device(*id_ptr));
-            if (device_ptr == nullptr) {
-                RB_TRACE("unknown device: not in context");
-                return nullptr;
-            }
+            m_poller.remove(fd);
+        }
+
+        void evdev_source::drop_backlog(device_id id) {
+            auto it = std::find_if(m_backlog.begin(), m_backlog.end(), [&](evdev_device* dev) {
+                return dev->get_id() == id;
+            });
 
-            return device_ptr;
+            if (it != m_backlog.end()) {
+                m_backlog.erase(it);
+            }
         }
 
         void evdev_source::drain_events() {
             RB_TRACE_ENTER();
 
-            if (!m_poller.poll()) {
+            auto rc = m_poller.poll();
+            if (rc < 0) {
+                m_ctx->log_warning(u8"evdev: failed to poll devices: %1%", posix_error_message(rc));
+                return;
+            }
+
+            process_completions();
+
+            if (rc == 0 && m_backlog.empty()) {
                 RB_TRACE("no events");
+                process_failures();
                 return;
             }
 
-            for (auto fd : m_poller.get_ready()) {
-                if (fd == m_inotify.get()) {
-                    process_inotify();
-                } else if (fd == m_inotify_udev.get()) {
-                    process_inotify_udev();
-                } else {
-                    auto device_ptr = get_device(fd);
-                    if (device_ptr != nullptr) {
-                        process_device(*device_ptr);
-                    }
+            // hotplug first, it may remove devices that are ready or in the backlog
+            for (size_t idx = 0; idx < m_poller.get_ready_count(); ++idx) {
+                auto owner = m_poller.get_ready(idx);
+
+                if (owner != nullptr && owner == m_monitor.get()) {
+                    process_hotplug();
                 }
             }
 
+            // devices left over from the previous drain get their turn first
+            m_ready.clear();
+            m_ready.swap(m_backlog);
+
+            for (size_t idx = 0; idx < m_poller.get_ready_count(); ++idx) {
+                auto owner = m_poller.get_ready(idx);
+
+                if (owner == nullptr || owner == m_monitor.get()) {
+                    continue;
+                }
+
+                auto device_ptr = static_cast<evdev_device*>(owner);
+                if (std::find(m_ready.begin(), m_ready.end(), device_ptr) == m_ready.end()) {
+                    m_ready.push_back(device_ptr);
+                }
+            }
+
+            process_ready();
+
+            if (m_reader != nullptr) {
+                auto submitted = m_reader->submit();
+                if (submitted < 0) {
+                    m_ctx->log_warning(u8"evdev: failed to submit io_uring reads: %1%", posix_error_message(submitted));
+                }
+            }
+
+            process_failures();
+
             for (auto&& pair : m_device_map) {
                 auto id = pair.second;
                 auto device_ptr = static_cast<evdev_device*>(m_ctx->get_device(id));
@@ -175,92 +234,228 @@ namespace multi_input {
             }
         }
 
-        void evdev_source::process_inotify() {
-            m_ctx->log_verbose("evdev: inotify fd ready");
-
-            while (true) {
-                std::aligned_storage_t<(sizeof(inotify_event) + NAME_MAX + 1) * 16, alignof(inotify_event)> buffer;
+        void evdev_source::drain_devices(const device_id* ids, size_t count) {
+            RB_TRACE_ENTER();
 
-                auto buffer_ptr = reinterpret_cast<unsigned char*>(&buffer);
-                auto length = read(m_inotify.get(), static_cast<void*>(buffer_ptr), sizeof(buffer));
+            // the fds are non-blocking, so they are read without polling,
+            // hotplug is left to the next drain_events
+            // with io_uring the completed reads are taken first, the devices
+            // that weren't asked for wait in the backlog
+            process_completions();
 
-                m_ctx->log_verbose("evdev: inotify length = %1%", length);
+            for (size_t idx = 0; idx < count; ++idx) {
+                if (m_device_map.id_to_fd(ids[idx]) == nullptr || m_quarantined.count(ids[idx]) != 0) {
+                    continue;
+                }
 
-                if (length == -1 && errno != EAGAIN) {
-                    throw_posix_error("Failed to process inotify event on /dev/input");
-                } else if (length < 0) {
-                    return;
+                auto device_ptr = static_cast<evdev_device*>(m_ctx->get_device(ids[idx]));
+                if (device_ptr == nullptr) {
+                    continue;
                 }
 
-                auto ptr = buffer_ptr;
-                auto end = buffer_ptr + length;
-                while (ptr < end) {
-                    auto event = reinterpret_cast<const inotify_event*>(ptr);
-                    ptr += event->len + sizeof(inotify_event);
-
-                    auto name = event->name;
-                    auto mask = event->mask;
-                    auto is_dir = (mask & IN_ISDIR) != 0;
-                    auto is_create = (mask & IN_CREATE) != 0;
-                    auto is_delete = (mask & IN_DELETE) != 0;
-
-                    if (is_dir) {
-                        continue;
-                    }
-
-                    if (is_create) {
-                        m_ctx->log_debug("evdev: inotify IN_CREATE name = %1% mask = %2%", name, mask);
-                        // we can't add_device immediately because udev needs to settle first
-                        // the other inotify instance is watching DELETE on /run/udev, because
-                        // when udev settles it removes /run/udev/queue
-                        m_pending.push_back(name);
-                    } else if (is_delete) {
-                        m_ctx->log_debug("evdev: inotify IN_DELETE name = %1% mask = %2%", name, mask);
-                        remove_device(name);
-                    }
+                size_t read = 0;
+                auto more = process_device(*device_ptr, drain_budget::no_event_limit, read);
+                device_ptr->post_update();
+
+                if (more && std::find(m_backlog.begin(), m_backlog.end(), device_ptr) == m_backlog.end()) {
+                    m_backlog.push_back(device_ptr);
                 }
             }
+
+            if (m_reader != nullptr) {
+                m_reader->submit();
+            }
+
+            process_failures();
         }
 
-        void evdev_source::process_inotify_udev() {
-            std::array<char, 128> buffer;
+        bool evdev_source::get_wait_fds(std::vector<int>& fds) {
+            // covers the devices and the uevent socket, so hotplug wakes waiters too
+            fds.push_back(m_poller.get_fd());
 
-            m_ctx->log_debug("evdev: udev settled");
-            while (read(m_inotify_udev.get(), buffer.data(), buffer.size()) >= 0) {
-                m_ctx->log_verbose("evdev: discarding udev inotify queue");
+            if (m_reader != nullptr) {
+                fds.push_back(m_reader->get_fd());
             }
 
-            for (auto&& name : m_pending) {
-                m_ctx->log_debug("evdev: adding pending device %1%", name);
-                add_device(name);
+            // the backlog raises no new edge, nothing would wake us for it
+            return !m_backlog.empty();
+        }
+
+        void evdev_source::process_ready() {
+            auto& budget = m_ctx->get_drain_budget();
+            auto quantum = budget.is_limited() ? device_quantum : drain_budget::no_event_limit;
+
+            // round-robin, a device that hit its quantum goes to the back
+            // of the queue until everything is read or the budget is spent
+            size_t next = 0;
+            while (next < m_ready.size() && !budget.is_spent()) {
+                auto device_ptr = m_ready[next++];
+
+                size_t read = 0;
+                auto more = process_device(*device_ptr, std::min(quantum, budget.get_events()), read);
+                budget.charge(read);
+
+                if (more) {
+                    m_ready.push_back(device_ptr);
+                }
             }
 
-            m_pending.clear();
+            m_backlog.assign(m_ready.begin() + static_cast<std::ptrdiff_t>(next), m_ready.end());
+            m_ready.clear();
         }
 
-        void evdev_source::process_device(evdev_device& dev) {
-            m_ctx->log_verbose("evdev: device %1% fd ready", dev.get_id());
-            auto&& handle = dev.get_handle();
-
-            while (true) {
-                input_event event{};
-                auto rc = libevdev_next_event(handle.get(), LIBEVDEV_READ_FLAG_NORMAL, &event);
-
-                if (rc == -EAGAIN || rc == LIBEVDEV_READ_STATUS_SYNC) {
-                    break;
-                } else if (rc == LIBEVDEV_READ_STATUS_SUCCESS) {
-                    dev.update(event);
-                } else if (rc < 0) {
-                    throw_posix_error(
-                        rc, "Failed while receiving an evdev event from device %1% (%2%)",
-                        dev.get_id(), handle.get_symbolic_name()
-                    );
+        void evdev_source::process_hotplug() {
+            m_uevents.clear();
+
+            auto rc = m_monitor->receive(m_uevents);
+            if (rc == -ENOBUFS) {
+                m_ctx->log_warning(u8"evdev: hotplug events were lost, rescanning devices");
+                rescan();
+                return;
+            } else if (rc < 0) {
+                m_ctx->log_warning(u8"evdev: failed to receive hotplug events: %1%", posix_error_message(rc));
+            }
+
+            // a burst of replugs of one node only applies its last action
+            m_hotplug.clear();
+
+            for (auto&& event : m_uevents) {
+                auto is_add = event.m_action == "add";
+                if ((!is_add && event.m_action != "remove") || event.m_subsystem != "input") {
+                    continue;
+                }
+
+                if (!boost::starts_with(event.m_devname, "/dev/input/event")) {
+                    continue;
+                }
+
+                auto name = event.m_devname.substr(sizeof("/dev/input/") - 1);
+                m_ctx->log_debug("evdev: uevent %1% %2%", event.m_action, name);
+
+                auto it = std::find_if(m_hotplug.begin(), m_hotplug.end(), [&](const std::pair<std::string, bool>& entry) {
+                    return entry.first == name;
+                });
+
+                if (it == m_hotplug.end()) {
+                    m_hotplug.emplace_back(name, is_add);
                 } else {
-                    m_ctx->log_warning("evdev: libevdev_next_event returned unexpected code: %1%", rc);
-                    assert(!"Impossible code path");
-                    break;
+                    it->second = is_add;
+                }
+            }
+
+            for (auto&& entry : m_hotplug) {
+                if (!entry.second) {
+                    remove_device(entry.first);
+                    continue;
+                }
+
+                // the node can be gone again already, that's one device lost, not the drain
+                try {
+                    add_device(entry.first);
+                } catch (const std::exception& ex) {
+                    m_ctx->log_warning(u8"evdev: failed to add device %1%: %2%", entry.first, ex.what());
+                }
+            }
+        }
+
+        void evdev_source::rescan() {
+            auto names = fs::list(m_sysfs_base_path);
+
+            std::vector<std::string> removed;
+            for (auto&& pair : m_device_map) {
+                if (std::find(names.begin(), names.end(), pair.first) == names.end()) {
+                    removed.push_back(pair.first);
+                }
+            }
+
+            for (auto&& name : removed) {
+                remove_device(name);
+            }
+
+            // unlike enum_devices the devices we still have keep their ids
+            for (auto&& name : names) {
+                if (m_device_map.name_to_id(name) != nullptr) {
+                    continue;
+                }
+
+                try {
+                    add_device(name);
+                } catch (const std::exception& ex) {
+                    m_ctx->log_warning(u8"evdev: failed to add device %1%: %2%", name, ex.what());
                 }
             }
         }
+
+        bool evdev_source::process_device(evdev_device& dev, size_t limit, size_t& read) {
+            auto rc = m_reader != nullptr ? dev.consume(limit, read) : dev.read_events(limit, read);
+
+            // removing the device now would invalidate the ready list of the caller
+            if (rc < 0) {
+                m_failures.emplace_back(dev.get_id(), rc);
+            } else if (rc == 0 && m_reader != nullptr) {
+                m_reader->post(dev);
+            }
+
+            return rc > 0;
+        }
+
+        void evdev_source::process_completions() {
+            if (m_reader == nullptr) {
+                return;
+            }
+
+            m_completions.clear();
+            m_reader->harvest(m_completions);
+
+            for (auto&& completion : m_completions) {
+                auto device_ptr = completion.first;
+
+                if (completion.second < 0) {
+                    m_failures.emplace_back(device_ptr->get_id(), completion.second);
+                } else if (std::find(m_backlog.begin(), m_backlog.end(), device_ptr) == m_backlog.end()) {
+                    m_backlog.push_back(device_ptr);
+                }
+            }
+        }
+
+        void evdev_source::process_failures() {
+            for (auto&& failure : m_failures) {
+                auto id = failure.first;
+                auto rc = failure.second;
+
+                auto name_ptr = m_device_map.id_to_name(id);
+                auto fd_ptr = m_device_map.id_to_fd(id);
+                if (name_ptr == nullptr || fd_ptr == nullptr) {
+                    continue;
+                }
+
+                auto name = *name_ptr;
+
+                if (rc == -ENODEV) {
+                    // unplugged mid-read, the remove uevent that follows finds nothing left to do
+                    m_ctx->log_info(u8"evdev: device %1% (%2%) disconnected", id, name);
+                    remove_device(name);
+                    continue;
+                }
+
+                m_ctx->log_warning(
+                    u8"evdev: quarantining device %1% (%2%) after a read failure: %3%",
+                    id, name, posix_error_message(rc)
+                );
+
+                release_device(id, *fd_ptr);
+                drop_backlog(id);
+                m_quarantined.insert(id);
+
+                // held buttons would stay down forever otherwise
+                auto device_ptr = m_ctx->get_device(id);
+                if (device_ptr != nullptr) {
+                    device_ptr->reset();
+                    device_ptr->set_usable(false);
+                }
+            }
+
+            m_failures.clear();
+        }
     }
 }
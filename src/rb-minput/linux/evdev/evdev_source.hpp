@@ -4,12 +4,14 @@
 #pragma once
 
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <memory>
 #include <vector>
 
-#include "linux/file_descriptor.hpp"
 #include "linux/poller.hpp"
+#include "linux/uevent_monitor.hpp"
+#include "linux/evdev/haptics_scheduler.hpp"
 #include "source.hpp"
 #include "utils.hpp"
 #include "api_types.hpp"
@@ -20,30 +22,28 @@ namespace multi_input {
     namespace lnx {
         struct evdev_device;
         struct evdev_handle;
+        struct uring_reader;
 
         struct evdev_device_map {
             RB_COPYABLE(evdev_device_map);
 
-            evdev_device_map() : m_name_to_id(), m_id_to_name(), m_fd_to_id(), m_id_to_fd() {}
+            evdev_device_map() : m_name_to_id(), m_id_to_name(), m_id_to_fd() {}
 
             void add(const std::string& name, int fd, device_id id) {
                 m_name_to_id.emplace(name, id);
                 m_id_to_name.emplace(id, name);
-                m_fd_to_id.emplace(fd, id);
                 m_id_to_fd.emplace(id, fd);
             }
 
-            void remove(const std::string& name, int fd, device_id id) {
+            void remove(const std::string& name, device_id id) {
                 m_name_to_id.erase(name);
                 m_id_to_name.erase(id);
-                m_fd_to_id.erase(fd);
                 m_id_to_fd.erase(id);
             }
 
             void clear() {
                 m_name_to_id.clear();
                 m_id_to_name.clear();
-                m_fd_to_id.clear();
                 m_id_to_fd.clear();
             }
 
@@ -57,11 +57,6 @@ namespace multi_input {
                 return it == m_id_to_name.end() ? nullptr : &it->second;
             }
 
-            device_id* fd_to_id(int fd) {
-                auto it = m_fd_to_id.find(fd);
-                return it == m_fd_to_id.end() ? nullptr : &it->second;
-            }
-
             int* id_to_fd(device_id id) {
                 auto it = m_id_to_fd.find(id);
                 return it == m_id_to_fd.end() ? nullptr : &it->second;
@@ -77,7 +72,6 @@ namespace multi_input {
         private:
             std::unordered_map<std::string, device_id> m_name_to_id;
             std::unordered_map<device_id, std::string> m_id_to_name;
-            std::unordered_map<int, device_id> m_fd_to_id;
             std::unordered_map<device_id, int> m_id_to_fd;
         };
 
@@ -88,20 +82,46 @@ namespace multi_input {
             virtual ~evdev_source();
             virtual void drain_events() override;
             virtual void enum_devices() override;
+            virtual void drain_devices(const device_id*, size_t) override;
+            virtual bool get_wait_fds(std::vector<int>&) override;
         private:
             void add_device(const std::string&);
             void remove_device(const std::string&);
-            evdev_device* get_device(int);
-            void process_inotify();
-            void process_inotify_udev();
-            void process_device(evdev_device&);
+            void drop_backlog(device_id);
+            void process_hotplug();
+            // adds and removes what changed while hotplug events were lost
+            void rescan();
+            // true if the device has more queued than the limit allowed
+            bool process_device(evdev_device&, size_t limit, size_t& read);
+            void process_failures();
+            void process_ready();
+            // queues the devices whose io_uring reads completed
+            void process_completions();
+            // stops reading the device, it's about to be removed or quarantined
+            void release_device(device_id, int fd);
 
             evdev_device_map m_device_map;
-            file_descriptor m_inotify;
-            file_descriptor m_inotify_udev;
+            std::unique_ptr<uevent_monitor> m_monitor;
+            std::vector<uevent> m_uevents;
+            // node name and whether it was added, the last action per node
+            std::vector<std::pair<std::string, bool>> m_hotplug;
             poller m_poller;
+            // devices are read through it when available, the poller then
+            // only watches hotplug
+            std::unique_ptr<uring_reader> m_reader;
+            std::vector<std::pair<evdev_device*, int>> m_completions;
             std::string m_sysfs_base_path;
-            std::vector<std::string> m_pending;
+            // read failures of this drain, handled once all devices were read
+            std::vector<std::pair<device_id, int>> m_failures;
+            // devices that failed with something other than a disconnect,
+            // not read anymore until their node is re-created
+            std::unordered_set<device_id> m_quarantined;
+            // devices read in turns this drain, those left unread go first
+            // in the next one, the poller is edge-triggered and won't report
+            // them again
+            std::vector<evdev_device*> m_ready;
+            std::vector<evdev_device*> m_backlog;
+            haptics_scheduler m_haptics;
         };
     }
 }
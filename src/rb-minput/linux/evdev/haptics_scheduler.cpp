@@ -0,0 +1,226 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#include <algorithm>
+
+#include "linux/evdev/haptics_scheduler.hpp"
+#include "linux/evdev/evdev_ff.hpp"
+#include "linux/posix.hpp"
+#include "context.hpp"
+
+namespace multi_input {
+    namespace lnx {
+        namespace {
+            // how often running timelines are sampled
+            constexpr long tick_ns = 10 * 1000 * 1000;
+
+            struct scheduled_target : haptics_target {
+                RB_NON_MOVEABLE(scheduled_target);
+
+                scheduled_target(haptics_scheduler& scheduler, std::weak_ptr<ff_effect_cache> cache) :
+                    m_scheduler(scheduler), m_cache(std::move(cache))
+                {
+                }
+
+                virtual bool play(haptics_timeline timeline) override {
+                    auto cache = m_cache.lock();
+                    if (cache == nullptr) {
+                        return false;
+                    }
+
+                    m_scheduler.submit(std::move(cache), std::move(timeline));
+                    return true;
+                }
+            private:
+                haptics_scheduler& m_scheduler;
+                std::weak_ptr<ff_effect_cache> m_cache;
+            };
+        }
+
+        haptics_scheduler::haptics_scheduler(context* ctx) :
+            m_ctx(ctx), m_commands(), m_timer(open_timer()), m_wakeup(open_event()),
+            m_idle(true), m_quit(false), m_started(), m_worker(), m_playing(), m_timer_armed(false)
+        {
+        }
+
+        haptics_scheduler::~haptics_scheduler() {
+            if (!m_worker.joinable()) {
+                return;
+            }
+
+            m_quit.store(true);
+
+            uint64_t value = 1;
+            if (write(m_wakeup.get(), &value, sizeof(value)) == -1) {
+                m_ctx->log_error("evdev: failed to wake up the haptics worker, detaching it");
+                m_worker.detach();
+                return;
+            }
+
+            m_worker.join();
+        }
+
+        void haptics_scheduler::submit(std::shared_ptr<ff_effect_cache> target, haptics_timeline timeline) {
+            std::call_once(m_started, [this]() { start_worker(); });
+
+            m_commands.push(command{std::move(target), std::move(timeline)});
+
+            // only pay for a syscall when the worker is asleep
+            if (m_idle.exchange(false)) {
+                uint64_t value = 1;
+                if (write(m_wakeup.get(), &value, sizeof(value)) == -1 && errno != EAGAIN) {
+                    throw_posix_error("Failed to wake up the haptics worker");
+                }
+            }
+        }
+
+        std::shared_ptr<haptics_target> haptics_scheduler::make_target(std::weak_ptr<ff_effect_cache> cache) {
+            return std::make_shared<scheduled_target>(*this, std::move(cache));
+        }
+
+        void haptics_scheduler::start_worker() {
+            // the first submission may come from any thread
+            m_ctx->log_deferred(log_level::debug, "evdev: starting haptics worker");
+            m_worker = std::thread{[this]() { run(); }};
+        }
+
+        void haptics_scheduler::run() {
+            while (!m_quit.load()) {
+                try {
+                    wait();
+
+                    auto now = clock::now();
+                    apply_commands(now);
+                    advance(now);
+
+                    set_timer(!m_playing.empty());
+                } catch (...) {
+                    m_ctx->log_deferred_exception();
+                }
+
+                if (m_playing.empty()) {
+                    m_idle.store(true);
+
+                    // a command may have been pushed before we marked ourselves idle
+                    if (!m_commands.empty() && m_idle.exchange(false)) {
+                        uint64_t value = 1;
+                        if (write(m_wakeup.get(), &value, sizeof(value)) == -1) {
+                            m_ctx->log_deferred(log_level::warning, "evdev: haptics worker failed to wake itself up");
+                        }
+                    }
+                }
+            }
+
+            for (auto&& item : m_playing) {
+                try {
+                    stop(item);
+                } catch (...) {
+                    m_ctx->log_deferred_exception();
+                }
+            }
+
+            m_playing.clear();
+        }
+
+        void haptics_scheduler::wait() {
+            std::array<pollfd, 2> fds{{
+                pollfd{ m_timer.get(), POLLIN, 0 },
+                pollfd{ m_wakeup.get(), POLLIN, 0 }
+            }};
+
+            if (::poll(fds.data(), fds.size(), -1) < 0 && errno != EINTR) {
+                throw_posix_error("Failed to wait for haptics events");
+            }
+
+            // both are non-blocking counters, we only care that they fired
+            uint64_t value{};
+            while (read(m_timer.get(), &value, sizeof(value)) > 0) {
+            }
+
+            while (read(m_wakeup.get(), &value, sizeof(value)) > 0) {
+            }
+        }
+
+        void haptics_scheduler::set_timer(bool armed) {
+            if (armed == m_timer_armed) {
+                return;
+            }
+
+            itimerspec spec{};
+            if (armed) {
+                spec.it_interval.tv_nsec = tick_ns;
+                spec.it_value.tv_nsec = tick_ns;
+            }
+
+            if (timerfd_settime(m_timer.get(), 0, &spec, nullptr) == -1) {
+                throw_posix_error("Failed to %1% the haptics timer", armed ? "arm" : "disarm");
+            }
+
+            m_timer_armed = armed;
+        }
+
+        void haptics_scheduler::apply_commands(clock::time_point now) {
+            m_commands.consume([&](command&& cmd) {
+                auto it = std::find_if(m_playing.begin(), m_playing.end(), [&](const playback& item) {
+                    return item.m_target == cmd.m_target;
+                });
+
+                if (cmd.m_timeline.empty()) {
+                    if (it != m_playing.end()) {
+                        try {
+                            stop(*it);
+                        } catch (...) {
+                            m_ctx->log_deferred_exception();
+                        }
+
+                        m_playing.erase(it);
+                    }
+                } else if (it != m_playing.end()) {
+                    it->m_timeline = std::move(cmd.m_timeline);
+                    it->m_start = now;
+                } else {
+                    m_playing.emplace_back(playback{std::move(cmd.m_target), std::move(cmd.m_timeline), now});
+                }
+            });
+        }
+
+        void haptics_scheduler::advance(clock::time_point now) {
+            auto it = m_playing.begin();
+
+            while (it != m_playing.end()) {
+                // the device is gone, closing our handle will stop the effects
+                if (it->m_target.use_count() == 1) {
+                    it = m_playing.erase(it);
+                    continue;
+                }
+
+                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - it->m_start).count();
+                float left{}, right{};
+                auto running = sample_timeline(it->m_timeline, static_cast<int>(elapsed), left, right);
+
+                try {
+                    auto&& target = *it->m_target;
+
+                    if (running) {
+                        // zero length effects play until replaced, so the cache can skip
+                        // the device entirely while the timeline holds a constant value
+                        target.play(ff_effect_cache::haptics_channel, make_rumble(left, right, 0));
+                        ++it;
+                        continue;
+                    }
+
+                    stop(*it);
+                } catch (...) {
+                    m_ctx->log_deferred_exception();
+                }
+
+                it = m_playing.erase(it);
+            }
+        }
+
+        void haptics_scheduler::stop(haptics_scheduler::playback& item) {
+            auto&& target = *item.m_target;
+            target.play(ff_effect_cache::haptics_channel, make_rumble(0, 0, 0));
+        }
+    }
+}
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "linux/file_descriptor.hpp"
+#include "haptics.hpp"
+#include "mpsc_queue.hpp"
+#include "utils.hpp"
+
+namespace multi_input {
+    struct context;
+
+    namespace lnx {
+        struct ff_effect_cache;
+
+        // plays rumble timelines on a worker thread woken by a timerfd
+        // submitting only pushes a command onto a lock-free queue, the worker
+        // sleeps on an eventfd while there's nothing to play
+        // the worker never calls the log sink, its messages wait in the
+        // context's deferred queue for the next drain
+        struct haptics_scheduler {
+            RB_NON_MOVEABLE(haptics_scheduler);
+
+            explicit haptics_scheduler(context*);
+            ~haptics_scheduler();
+
+            // an empty timeline stops whatever is playing on the target
+            void submit(std::shared_ptr<ff_effect_cache>, haptics_timeline);
+
+            // the target handed to the context for a device, it doesn't keep
+            // the cache alive so the worker still sees the device go away
+            std::shared_ptr<haptics_target> make_target(std::weak_ptr<ff_effect_cache>);
+        private:
+            using clock = std::chrono::steady_clock;
+
+            struct command {
+                std::shared_ptr<ff_effect_cache> m_target;
+                haptics_timeline m_timeline;
+            };
+
+            struct playback {
+                std::shared_ptr<ff_effect_cache> m_target;
+                haptics_timeline m_timeline;
+                clock::time_point m_start;
+            };
+
+            void start_worker();
+            void run();
+            void wait();
+            void set_timer(bool);
+            void apply_commands(clock::time_point);
+            void advance(clock::time_point);
+            void stop(playback&);
+
+            context* m_ctx;
+            mpsc_queue<command> m_commands;
+            file_descriptor m_timer;
+            file_descriptor m_wakeup;
+            std::atomic<bool> m_idle;
+            std::atomic<bool> m_quit;
+            std::once_flag m_started;
+            std::thread m_worker;
+            std::vector<playback> m_playing;
+            bool m_timer_armed;
+        };
+    }
+}
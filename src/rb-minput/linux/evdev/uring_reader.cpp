@@ -0,0 +1,246 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#include <algorithm>
+
+#include "linux/evdev/uring_reader.hpp"
+#include "linux/evdev/evdev.hpp"
+#include "context.hpp"
+
+namespace multi_input {
+    namespace lnx {
+#if defined(RB_HAS_IO_URING)
+        namespace {
+            // a read per device plus cancellations, a full queue is submitted early
+            constexpr unsigned ring_entries = 256;
+        }
+
+        uring_reader::uring_reader(context* ctx) :
+            m_ctx(ctx), m_slots(), m_orphans(), m_ring(), m_initialized(false)
+        {
+        }
+
+        std::unique_ptr<uring_reader> uring_reader::create(context* ctx) {
+            std::unique_ptr<uring_reader> reader{new uring_reader(ctx)};
+
+            // no COOP_TASKRUN, completions have to show up in the ring without
+            // us entering the kernel
+            auto rc = io_uring_queue_init(ring_entries, &reader->m_ring, 0);
+            if (rc < 0) {
+                ctx->log_info(u8"evdev: io_uring unavailable (%1%), polling devices with epoll", posix_error_message(rc));
+                return nullptr;
+            }
+
+            reader->m_initialized = true;
+            ctx->log_debug(u8"evdev: reading devices through io_uring");
+            return reader;
+        }
+
+        uring_reader::~uring_reader() {
+            if (!m_initialized) {
+                return;
+            }
+
+            // the kernel may write into a slot until its read completes, cancel
+            // every read in flight and reap them before the buffers go away
+            size_t pending = 0;
+            auto cancel_read = [&](read_slot& slot) {
+                if (!slot.m_in_flight) {
+                    return;
+                }
+
+                auto sqe = get_sqe();
+                if (sqe != nullptr) {
+                    io_uring_prep_cancel(sqe, &slot, 0);
+                    io_uring_sqe_set_data(sqe, nullptr);
+                }
+
+                ++pending;
+            };
+
+            for (auto& pair : m_slots) {
+                cancel_read(*pair.second);
+            }
+
+            // orphans were cancelled already, again in case the queue was full
+            for (auto& slot : m_orphans) {
+                cancel_read(*slot);
+            }
+
+            io_uring_submit(&m_ring);
+
+            while (pending > 0) {
+                io_uring_cqe* cqe = nullptr;
+                auto rc = io_uring_wait_cqe(&m_ring, &cqe);
+                if (rc == -EINTR) {
+                    continue;
+                }
+
+                if (rc < 0) {
+                    m_ctx->log_error(u8"evdev: waiting for io_uring reads to cancel failed (%1%)", posix_error_message(rc));
+                    break;
+                }
+
+                // the cancellations complete with no data
+                auto slot = static_cast<read_slot*>(io_uring_cqe_get_data(cqe));
+                if (slot != nullptr && slot->m_in_flight) {
+                    slot->m_in_flight = false;
+                    --pending;
+                }
+
+                io_uring_cqe_seen(&m_ring, cqe);
+            }
+
+            io_uring_queue_exit(&m_ring);
+        }
+
+        void uring_reader::post(evdev_device& dev) {
+            auto& slot = m_slots[&dev];
+
+            if (slot == nullptr) {
+                auto fd = dev.get_handle().get_fd();
+
+                // io_uring fails reads of non-blocking files with EAGAIN instead
+                // of waiting, nothing else reads the device while we own it
+                auto flags = fcntl(fd, F_GETFL);
+                if (flags >= 0 && (flags & O_NONBLOCK) != 0) {
+                    fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+                }
+
+                slot.reset(new read_slot{&dev, fd, false, {}});
+            }
+
+            if (slot->m_in_flight) {
+                return;
+            }
+
+            auto sqe = get_sqe();
+            if (sqe == nullptr) {
+                m_ctx->log_warning(u8"evdev: io_uring queue full, device %1% not read", dev.get_id());
+                return;
+            }
+
+            // evdev nodes are streams, -1 reads at the current position like read(2)
+            io_uring_prep_read(sqe, slot->m_fd, slot->m_events.data(), sizeof(slot->m_events), static_cast<uint64_t>(-1));
+            io_uring_sqe_set_data(sqe, slot.get());
+            slot->m_in_flight = true;
+        }
+
+        void uring_reader::cancel(evdev_device& dev) {
+            auto it = m_slots.find(&dev);
+            if (it == m_slots.end()) {
+                return;
+            }
+
+            auto slot = std::move(it->second);
+            m_slots.erase(it);
+
+            if (!slot->m_in_flight) {
+                return;
+            }
+
+            slot->m_device = nullptr;
+
+            auto sqe = get_sqe();
+            if (sqe != nullptr) {
+                io_uring_prep_cancel(sqe, slot.get(), 0);
+                io_uring_sqe_set_data(sqe, nullptr);
+            }
+
+            m_orphans.push_back(std::move(slot));
+
+            // the read holds the file open, let it go with the device
+            io_uring_submit(&m_ring);
+        }
+
+        int uring_reader::submit() {
+            auto rc = io_uring_submit(&m_ring);
+            return rc < 0 ? rc : 0;
+        }
+
+        void uring_reader::harvest(std::vector<std::pair<evdev_device*, int>>& completed) {
+            io_uring_cqe* cqe = nullptr;
+            unsigned head = 0;
+            unsigned seen = 0;
+
+            io_uring_for_each_cqe(&m_ring, head, cqe) {
+                ++seen;
+
+                auto slot = static_cast<read_slot*>(io_uring_cqe_get_data(cqe));
+                if (slot == nullptr) {
+                    continue;
+                }
+
+                slot->m_in_flight = false;
+
+                if (slot->m_device == nullptr) {
+                    auto it = std::find_if(m_orphans.begin(), m_orphans.end(), [&](const std::unique_ptr<read_slot>& orphan) {
+                        return orphan.get() == slot;
+                    });
+
+                    if (it != m_orphans.end()) {
+                        m_orphans.erase(it);
+                    }
+                    continue;
+                }
+
+                auto rc = cqe->res;
+
+                if (rc == -EAGAIN || rc == -EINTR) {
+                    // nothing read, consuming the empty buffer posts it again
+                    completed.emplace_back(slot->m_device, 0);
+                } else if (rc < 0) {
+                    completed.emplace_back(slot->m_device, rc);
+                } else {
+                    // the kernel only hands out whole events
+                    slot->m_device->fill(slot->m_events.data(), static_cast<size_t>(rc) / sizeof(input_event));
+                    completed.emplace_back(slot->m_device, 0);
+                }
+            }
+
+            io_uring_cq_advance(&m_ring, seen);
+        }
+
+        int uring_reader::get_fd() const {
+            return m_ring.ring_fd;
+        }
+
+        io_uring_sqe* uring_reader::get_sqe() {
+            auto sqe = io_uring_get_sqe(&m_ring);
+
+            if (sqe == nullptr) {
+                io_uring_submit(&m_ring);
+                sqe = io_uring_get_sqe(&m_ring);
+            }
+
+            return sqe;
+        }
+#else
+        uring_reader::uring_reader(context* ctx) : m_ctx(ctx), m_slots(), m_orphans() {}
+
+        std::unique_ptr<uring_reader> uring_reader::create(context*) {
+            return nullptr;
+        }
+
+        uring_reader::~uring_reader() {
+        }
+
+        void uring_reader::post(evdev_device&) {
+        }
+
+        void uring_reader::cancel(evdev_device&) {
+        }
+
+        int uring_reader::submit() {
+            return 0;
+        }
+
+        void uring_reader::harvest(std::vector<std::pair<evdev_device*, int>>&) {
+        }
+
+        int uring_reader::get_fd() const {
+            return -1;
+        }
+#endif
+    }
+}
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <utility>
+
+#include "linux/evdev/evdev_device.hpp"
+#include "utils.hpp"
+#include "api_types.hpp"
+
+#if defined(RB_HAS_IO_URING)
+#   include <liburing.h>
+#endif
+
+namespace multi_input {
+    struct context;
+
+    namespace lnx {
+        // keeps a read posted on every device, completions are taken from the
+        // shared ring without a syscall and the reads consumed during a drain
+        // are posted again with a single submit
+        // without liburing or kernel support create returns nullptr and the
+        // source polls the devices with epoll instead
+        struct uring_reader {
+            RB_NON_MOVEABLE(uring_reader);
+
+            static std::unique_ptr<uring_reader> create(context*);
+            ~uring_reader();
+
+            // queues a read into a buffer of our own unless one is in flight,
+            // nothing reaches the kernel before submit
+            void post(evdev_device&);
+            // the device may be destroyed right after, a read still in flight
+            // completes into a buffer kept until the cancellation is reaped
+            void cancel(evdev_device&);
+            // 0 or a negative errno
+            int submit();
+
+            // fills the devices whose reads completed and appends them with 0,
+            // or with a negative errno when the read failed
+            void harvest(std::vector<std::pair<evdev_device*, int>>&);
+
+            // the ring, readable while completions are waiting
+            int get_fd() const;
+        private:
+            explicit uring_reader(context*);
+
+            struct read_slot {
+                evdev_device* m_device;
+                int m_fd;
+                bool m_in_flight;
+                std::array<input_event, evdev_device::read_capacity> m_events;
+            };
+
+            context* m_ctx;
+            std::unordered_map<evdev_device*, std::unique_ptr<read_slot>> m_slots;
+            // slots of removed devices whose read hasn't completed yet
+            std::vector<std::unique_ptr<read_slot>> m_orphans;
+#if defined(RB_HAS_IO_URING)
+            io_uring_sqe* get_sqe();
+
+            io_uring m_ring;
+            bool m_initialized;
+#endif
+        };
+    }
+}
@@ -35,16 +35,32 @@ namespace multi_input {
             return open_file_flags(path, O_RDWR | O_CLOEXEC | O_NONBLOCK);
         }
 
-        file_descriptor open_inotify() {
-            auto fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        file_descriptor open_null() {
+            return open_file_flags("/dev/null", O_WRONLY | O_CLOEXEC | O_NONBLOCK);
+        }
+
+        file_descriptor open_timer() {
+            auto fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
             if (fd < 0) {
-                throw_posix_error("Failed to create inotify instance");
+                throw_posix_error("Failed to create timerfd instance");
             }
             return file_descriptor{fd};
         }
 
-        file_descriptor open_null() {
-            return open_file_flags("/dev/null", O_WRONLY | O_CLOEXEC | O_NONBLOCK);
+        file_descriptor open_event() {
+            auto fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (fd < 0) {
+                throw_posix_error("Failed to create eventfd instance");
+            }
+            return file_descriptor{fd};
+        }
+
+        file_descriptor duplicate(int fd) {
+            auto new_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+            if (new_fd < 0) {
+                throw_posix_error("Failed to duplicate file descriptor %1%", fd);
+            }
+            return file_descriptor{new_fd};
         }
     }
 }
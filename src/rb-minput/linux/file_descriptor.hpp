@@ -24,7 +24,9 @@ namespace multi_input {
 
         file_descriptor open_file(const std::string&);
         file_descriptor open_file_rw(const std::string&);
-        file_descriptor open_inotify();
         file_descriptor open_null();
+        file_descriptor open_timer();
+        file_descriptor open_event();
+        file_descriptor duplicate(int);
     }
 }
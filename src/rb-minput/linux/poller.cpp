@@ -6,42 +6,64 @@
 
 namespace multi_input {
     namespace lnx {
-        poller::poller() : m_fds() {}
-
-        void poller::add(int fd) {
-            m_fds.emplace_back(pollfd{ fd, POLLIN, 0 });
+        namespace {
+            file_descriptor open_epoll() {
+                auto fd = epoll_create1(EPOLL_CLOEXEC);
+                if (fd < 0) {
+                    throw_posix_error("Failed to create epoll instance");
+                }
+                return file_descriptor{fd};
+            }
         }
 
-        void poller::remove(int fd) {
-            auto it = std::find_if(m_fds.begin(), m_fds.end(), [&](const pollfd& p) {
-                return p.fd == fd;
-            });
+        poller::poller() : m_epoll(open_epoll()), m_owners(), m_events(16), m_ready_count(0) {}
 
-            if (it != m_fds.end()) {
-                m_fds.erase(it);
+        void poller::add(int fd, void* owner) {
+            epoll_event event{};
+            event.events = EPOLLIN | EPOLLET;
+            event.data.ptr = owner;
+
+            if (epoll_ctl(m_epoll.get(), EPOLL_CTL_ADD, fd, &event) < 0) {
+                throw_posix_error("Failed to add file descriptor %1% to epoll", fd);
             }
-        }
 
-        bool poller::poll() {
-            auto rc = ::poll(m_fds.data(), m_fds.size(), 0);
-            if (rc < 0) {
-                throw_posix_error("Failed to poll devices");
+            m_owners[fd] = owner;
+
+            if (m_events.size() < m_owners.size()) {
+                m_events.resize(m_owners.size());
             }
-            return rc > 0;
         }
 
-        std::vector<int> poller::get_ready() {
-            std::vector<int> ready{};
+        void poller::remove(int fd) {
+            auto it = m_owners.find(fd);
+            if (it == m_owners.end()) {
+                return;
+            }
+
+            auto owner = it->second;
+            m_owners.erase(it);
+
+            // fails for descriptors already closed, they left the set on their own
+            epoll_ctl(m_epoll.get(), EPOLL_CTL_DEL, fd, nullptr);
 
-            for (auto&& entry : m_fds) {
-                if ((entry.revents & POLLIN) == 0) {
-                    continue;
+            for (size_t idx = 0; idx < m_ready_count; ++idx) {
+                if (m_events[idx].data.ptr == owner) {
+                    m_events[idx].data.ptr = nullptr;
                 }
+            }
+        }
 
-                ready.push_back(entry.fd);
+        int poller::poll() {
+            m_ready_count = 0;
+
+            auto rc = epoll_wait(m_epoll.get(), m_events.data(), static_cast<int>(m_events.size()), 0);
+            if (rc < 0) {
+                // a signal during a zero timeout wait just means nothing is ready yet
+                return errno == EINTR ? 0 : -errno;
             }
 
-            return ready;
+            m_ready_count = static_cast<size_t>(rc);
+            return rc;
         }
     }
 }
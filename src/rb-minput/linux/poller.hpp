@@ -4,25 +4,55 @@
 #pragma once
 
 #include <vector>
-#include <algorithm>
+#include <unordered_map>
 
+#include "linux/file_descriptor.hpp"
 #include "utils.hpp"
 
-#include <poll.h>
+#include <sys/epoll.h>
 
 namespace multi_input {
     namespace lnx {
+        // an edge-triggered epoll set, every descriptor is registered with
+        // the object that handles it, so readiness costs O(ready) and needs
+        // no lookups
+        // being edge-triggered, an owner that stops reading before EAGAIN
+        // is not reported again until new data arrives and has to keep
+        // track of it itself
         struct poller {
-            RB_MOVEABLE(poller);
+            RB_NON_MOVEABLE(poller);
 
             poller();
 
-            void add(int fd);
+            void add(int fd, void* owner);
+            // also drops the pending ready entries of the descriptor, so an
+            // owner destroyed while the ready list is walked isn't reached
             void remove(int fd);
-            bool poll();
-            std::vector<int> get_ready();
+            // number of ready descriptors, or a negative errno, never throws
+            int poll();
+
+            // the epoll instance, readable while any descriptor is ready
+            int get_fd() {
+                return m_epoll.get();
+            }
+
+            // owners of the descriptors ready at the last poll, null for the
+            // removed ones, valid until the next call
+            // descriptors in an error or hangup state are ready too, their
+            // read reports what happened
+            size_t get_ready_count() const {
+                return m_ready_count;
+            }
+
+            void* get_ready(size_t idx) const {
+                return m_events[idx].data.ptr;
+            }
         private:
-            std::vector<pollfd> m_fds;
+            file_descriptor m_epoll;
+            std::unordered_map<int, void*> m_owners;
+            // reused by every poll, grows with the number of descriptors
+            std::vector<epoll_event> m_events;
+            size_t m_ready_count;
         };
     }
 }
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <errno.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -13,7 +14,8 @@
 #include <dirent.h>
 #include <stdlib.h>
 #include <libgen.h>
-#include <sys/inotify.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
 
 #ifdef min
 #   undef min
@@ -31,8 +33,8 @@
 
 namespace multi_input {
     namespace lnx {
-        template <typename... Args>
-        void throw_posix_error(int last_error, const std::string& fmt, Args&&... args) {
+        // accepts errno or the negated codes libevdev returns
+        inline std::string posix_error_message(int last_error) {
             std::array<char, 2048> error_buffer{};
 
             if (last_error < 0) {
@@ -40,8 +42,13 @@ namespace multi_input {
             }
 
             auto error_message = strerror_r(last_error, error_buffer.data(), error_buffer.size() - 1);
+            return format("%1%", error_message);
+        }
+
+        template <typename... Args>
+        void throw_posix_error(int last_error, const std::string& fmt, Args&&... args) {
             auto message = format(fmt, std::forward<Args>(args)...);
-            auto full_message = format("%1%: %2%", message, error_message);
+            auto full_message = format("%1%: %2%", message, posix_error_message(last_error));
             throw std::runtime_error(full_message);
         }
 
@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#include <array>
+#include <cstring>
+#include <cstdint>
+
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <arpa/inet.h>
+
+#include "linux/uevent_monitor.hpp"
+#include "linux/posix.hpp"
+#include "context.hpp"
+
+namespace multi_input {
+    namespace lnx {
+        namespace {
+            // the multicast group udevd re-broadcasts processed events on,
+            // group 1 carries the raw kernel ones
+            constexpr uint32_t udev_group = 2;
+            constexpr uint32_t udev_magic = 0xfeedcafe;
+
+            // as sent by libudev, the integers are in host order except the magic
+            struct udev_header {
+                char m_prefix[8];
+                uint32_t m_magic;
+                uint32_t m_header_size;
+                uint32_t m_properties_offset;
+                uint32_t m_properties_length;
+                uint32_t m_filter_subsystem_hash;
+                uint32_t m_filter_devtype_hash;
+                uint32_t m_filter_tag_bloom_hi;
+                uint32_t m_filter_tag_bloom_lo;
+            };
+
+            bool parse_uevent(const char* data, size_t length, uevent& event) {
+                if (length < sizeof(udev_header)) {
+                    return false;
+                }
+
+                udev_header header;
+                std::memcpy(&header, data, sizeof(header));
+
+                if (std::strncmp(header.m_prefix, "libudev", sizeof(header.m_prefix)) != 0 || ntohl(header.m_magic) != udev_magic) {
+                    return false;
+                }
+
+                if (header.m_properties_offset > length || header.m_properties_length > length - header.m_properties_offset) {
+                    return false;
+                }
+
+                // KEY=value pairs, each terminated with a NUL
+                auto ptr = data + header.m_properties_offset;
+                auto end = ptr + header.m_properties_length;
+
+                while (ptr < end) {
+                    auto next = static_cast<const char*>(std::memchr(ptr, '\0', static_cast<size_t>(end - ptr)));
+                    if (next == nullptr) {
+                        next = end;
+                    }
+
+                    auto separator = static_cast<const char*>(std::memchr(ptr, '=', static_cast<size_t>(next - ptr)));
+                    if (separator != nullptr) {
+                        auto key_length = static_cast<size_t>(separator - ptr);
+                        std::string value{separator + 1, next};
+
+                        if (key_length == 6 && std::strncmp(ptr, "ACTION", key_length) == 0) {
+                            event.m_action = std::move(value);
+                        } else if (key_length == 9 && std::strncmp(ptr, "SUBSYSTEM", key_length) == 0) {
+                            event.m_subsystem = std::move(value);
+                        } else if (key_length == 7 && std::strncmp(ptr, "DEVNAME", key_length) == 0) {
+                            event.m_devname = std::move(value);
+                        }
+                    }
+
+                    ptr = next + 1;
+                }
+
+                return !event.m_action.empty();
+            }
+        }
+
+        uevent_monitor::uevent_monitor(file_descriptor&& socket) : m_socket(std::move(socket)) {
+        }
+
+        std::unique_ptr<uevent_monitor> uevent_monitor::create(context* ctx) {
+            auto fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+            if (fd < 0) {
+                ctx->log_warning(u8"uevent: failed to open netlink socket: %1%", posix_error_message(errno));
+                return nullptr;
+            }
+
+            file_descriptor handle{fd};
+
+            sockaddr_nl address{};
+            address.nl_family = AF_NETLINK;
+            address.nl_groups = udev_group;
+
+            if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+                ctx->log_warning(u8"uevent: failed to bind netlink socket: %1%", posix_error_message(errno));
+                return nullptr;
+            }
+
+            // the sender's credentials tell udevd apart from other processes
+            int enable = 1;
+            setsockopt(fd, SOL_SOCKET, SO_PASSCRED, &enable, sizeof(enable));
+
+            // a burst of replugs shouldn't overflow before the next drain, the
+            // kernel caps it at rmem_max for unprivileged processes
+            int buffer_size = 1 << 20;
+            setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+
+            return std::unique_ptr<uevent_monitor>{new uevent_monitor(std::move(handle))};
+        }
+
+        int uevent_monitor::receive(std::vector<uevent>& events) {
+            auto lost = false;
+
+            while (true) {
+                std::array<char, 8192> buffer;
+                alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(ucred))> control;
+
+                iovec vector{buffer.data(), buffer.size()};
+                sockaddr_nl sender{};
+
+                msghdr message{};
+                message.msg_name = &sender;
+                message.msg_namelen = sizeof(sender);
+                message.msg_iov = &vector;
+                message.msg_iovlen = 1;
+                message.msg_control = control.data();
+                message.msg_controllen = control.size();
+
+                auto length = recvmsg(m_socket.get(), &message, 0);
+
+                if (length < 0 && errno == EINTR) {
+                    continue;
+                } else if (length < 0 && errno == ENOBUFS) {
+                    // the queue is still read to the end, the edge-triggered poller won't report it again
+                    lost = true;
+                    continue;
+                } else if (length < 0) {
+                    return errno == EAGAIN ? (lost ? -ENOBUFS : 0) : -errno;
+                }
+
+                if ((message.msg_flags & MSG_TRUNC) != 0 || sender.nl_pid == 0) {
+                    continue;
+                }
+
+                // only udevd, running as root, is trusted
+                auto header = CMSG_FIRSTHDR(&message);
+                if (header == nullptr || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_CREDENTIALS) {
+                    continue;
+                }
+
+                ucred credentials;
+                std::memcpy(&credentials, CMSG_DATA(header), sizeof(credentials));
+                if (credentials.uid != 0) {
+                    continue;
+                }
+
+                uevent event;
+                if (parse_uevent(buffer.data(), static_cast<size_t>(length), event)) {
+                    events.push_back(std::move(event));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "linux/file_descriptor.hpp"
+#include "utils.hpp"
+
+namespace multi_input {
+    struct context;
+
+    namespace lnx {
+        // the parts of a device event the sources care about
+        struct uevent {
+            std::string m_action;
+            std::string m_subsystem;
+            std::string m_devname;
+        };
+
+        // listens to the uevents udev broadcasts once it has processed a
+        // device, so its database entry and node permissions are in place
+        // when the message arrives
+        // without netlink (some sandboxes) create returns nullptr
+        struct uevent_monitor {
+            RB_NON_MOVEABLE(uevent_monitor);
+
+            static std::unique_ptr<uevent_monitor> create(context*);
+
+            // appends everything queued, 0 or a negative errno, -ENOBUFS means
+            // messages were lost and the caller has to rescan
+            int receive(std::vector<uevent>&);
+
+            int get_fd() {
+                return m_socket.get();
+            }
+        private:
+            explicit uevent_monitor(file_descriptor&&);
+
+            file_descriptor m_socket;
+        };
+    }
+}
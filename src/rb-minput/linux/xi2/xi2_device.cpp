@@ -347,6 +347,18 @@ namespace multi_input {
         }
 
         void xi2_device::update(XIRawEvent& event) {
+            // the server time is CLOCK_MONOTONIC in milliseconds truncated to 32 bits,
+            // widen it against steady_now so it's comparable with evdev timestamps
+            // a server with another clock (e.g. remote) gives nonsense ages, use drain time then
+            auto now = steady_now();
+            auto age = static_cast<event_time>(static_cast<uint32_t>(now / 1000) - static_cast<uint32_t>(event.time)) * 1000;
+
+            if (age <= max_server_time_age && age <= now) {
+                auto time = now - age;
+                set_event_time(time);
+                m_latency.record_report(time);
+            }
+
             switch (event.evtype) {
                 case XI_RawKeyPress:
                 case XI_RawKeyRelease:
@@ -395,7 +407,7 @@ namespace multi_input {
                 }
 
                 auto value = *valuator++;
-                virtual_axis *axis = nullptr;
+                axis_ref axis{};
 
                 if (idx == m_axis_rel_x) {
                     axis = get_axis(input_code::mouse_x);
@@ -30,6 +30,9 @@ namespace multi_input {
             input_code map_key_code(int);
             input_code map_button_code(int);
 
+            // older server timestamps are assumed to be on a different clock
+            static constexpr event_time max_server_time_age = 10000000;
+
             int m_x11_id;
             Display *m_display;
             int m_axis_rel_x;
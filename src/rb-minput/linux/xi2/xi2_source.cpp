@@ -5,6 +5,7 @@
 #include <array>
 #include <unordered_map>
 #include <cassert>
+#include <algorithm>
 
 #include <boost/algorithm/string/predicate.hpp>
 
@@ -62,9 +63,20 @@ namespace multi_input {
         }
 
         void xi2_source::drain_events() {
-            while (has_next_event()) {
+            auto& budget = m_ctx->get_drain_budget();
+            // the clock is read once per batch, events past the budget stay
+            // queued in Xlib and get_wait_fds reports them
+            constexpr size_t batch = 32;
+            size_t read = 0;
+
+            while (!budget.is_spent() && has_next_event()) {
                 x11_event event{m_display.get(), m_opcode};
 
+                if (++read == std::min(batch, budget.get_events())) {
+                    budget.charge(read);
+                    read = 0;
+                }
+
                 if (!event.is_valid()) {
                     continue;
                 }
@@ -83,6 +95,30 @@ namespace multi_input {
                         break;
                 }
             }
+
+            budget.charge(read);
+        }
+
+        void xi2_source::drain_devices(const device_id* ids, size_t count) {
+            // all devices share one X event queue, so it's drained as a whole
+            // whenever one of ours is requested
+            for (auto&& pair : m_device_map) {
+                if (std::find(ids, ids + count, pair.second) != ids + count) {
+                    drain_events();
+                    return;
+                }
+            }
+        }
+
+        bool xi2_source::get_wait_fds(std::vector<int>& fds) {
+            auto display = m_display.get();
+
+            // requests still in the output buffer would never get their replies
+            XFlush(display);
+            fds.push_back(ConnectionNumber(display));
+
+            // events Xlib already read from the socket don't make it readable again
+            return XEventsQueued(display, QueuedAlready) > 0;
         }
 
         bool xi2_source::has_next_event() {
@@ -196,7 +232,7 @@ namespace multi_input {
 
             RB_TRACE("creating new device object");
             auto id = m_ctx->get_next_id();
-            m_ctx->add_device(std::unique_ptr<device>{new xi2_device(m_ctx, id, m_display.get(), info)});
+            m_ctx->add_device(std::unique_ptr<device>{new (m_ctx) xi2_device(m_ctx, id, m_display.get(), info)});
             m_device_map.emplace(info.deviceid, id);
         }
 
@@ -25,6 +25,8 @@ namespace multi_input {
             virtual ~xi2_source();
             virtual void drain_events() override;
             virtual void enum_devices() override;
+            virtual void drain_devices(const device_id*, size_t) override;
+            virtual bool get_wait_fds(std::vector<int>&) override;
         private:
             bool has_next_event();
             void add_device(XIDeviceInfo&);
@@ -18,17 +18,17 @@ namespace multi_input {
     inline api_string to_string(log_level level) {
         switch (level) {
             case log_level::debug_verbose:
-                return u8"verbose";
+                return "verbose";
             case log_level::debug:
-                return u8"debug";
+                return "debug";
             case log_level::info:
-                return u8"info";
+                return "info";
             case log_level::warning:
-                return u8"warning";
+                return "warning";
             case log_level::error:
-                return u8"error";
+                return "error";
             default:
-                return u8"unknown";
+                return "unknown";
         }
     }
 }
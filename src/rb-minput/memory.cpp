@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#include "memory.hpp"
+
+namespace multi_input {
+    namespace {
+        void* RB_APICALL default_alloc(user_data, size_t size, size_t) {
+            return ::operator new(size, std::nothrow);
+        }
+
+        void RB_APICALL default_free(user_data, void* ptr, size_t) {
+            ::operator delete(ptr);
+        }
+
+        struct alignas(std::max_align_t) block_header {
+            memory_pool* m_pool;
+            size_t m_size;
+        };
+    }
+
+    void* allocator::allocate(size_t size, size_t alignment) {
+        auto ptr = m_alloc(m_user_data, size, alignment);
+
+        if (ptr == nullptr) {
+            throw std::bad_alloc{};
+        }
+
+        return ptr;
+    }
+
+    void allocator::deallocate(void* ptr, size_t size) {
+        m_free(m_user_data, ptr, size);
+    }
+
+    allocator default_allocator() {
+        return allocator{default_alloc, default_free, nullptr};
+    }
+
+    memory_pool::memory_pool(allocator alloc) :
+        m_allocator(alloc), m_free()
+    {
+    }
+
+    memory_pool::~memory_pool() {
+        for (size_t idx = 0; idx < class_count; ++idx) {
+            auto block = m_free[idx];
+
+            while (block != nullptr) {
+                auto next = block->m_next;
+                m_allocator.deallocate(block, size_of_class(idx));
+                block = next;
+            }
+        }
+    }
+
+    size_t memory_pool::class_of(size_t size) {
+        size_t index = 0;
+        auto block = min_block_size;
+
+        while (block < size) {
+            block <<= 1;
+            ++index;
+        }
+
+        return index;
+    }
+
+    size_t memory_pool::size_of_class(size_t index) {
+        return min_block_size << index;
+    }
+
+    void* memory_pool::allocate(size_t size) {
+        if (size > max_block_size) {
+            return m_allocator.allocate(size, alignof(std::max_align_t));
+        }
+
+        auto index = class_of(size);
+        auto block = m_free[index];
+
+        if (block != nullptr) {
+            m_free[index] = block->m_next;
+            return block;
+        }
+
+        return m_allocator.allocate(size_of_class(index), alignof(std::max_align_t));
+    }
+
+    void memory_pool::deallocate(void* ptr, size_t size) {
+        if (ptr == nullptr) {
+            return;
+        }
+
+        if (size > max_block_size) {
+            m_allocator.deallocate(ptr, size);
+            return;
+        }
+
+        auto index = class_of(size);
+        auto block = static_cast<free_block*>(ptr);
+        block->m_next = m_free[index];
+        m_free[index] = block;
+    }
+
+    void* pool_new(memory_pool& pool, size_t size) {
+        auto total = sizeof(block_header) + size;
+        auto header = static_cast<block_header*>(pool.allocate(total));
+
+        header->m_pool = &pool;
+        header->m_size = total;
+        return header + 1;
+    }
+
+    void pool_delete(void* ptr) {
+        if (ptr == nullptr) {
+            return;
+        }
+
+        auto header = static_cast<block_header*>(ptr) - 1;
+        header->m_pool->deallocate(header, header->m_size);
+    }
+}
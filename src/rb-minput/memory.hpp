@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <new>
+
+#include "utils.hpp"
+#include "api_types.hpp"
+
+namespace multi_input {
+    // user supplied allocation hooks, defaults to the global heap
+    struct allocator {
+        alloc_callback m_alloc;
+        free_callback m_free;
+        user_data m_user_data;
+
+        void* allocate(size_t, size_t);
+        void deallocate(void*, size_t);
+    };
+
+    allocator default_allocator();
+
+    // recycles blocks in power-of-two size classes instead of handing them
+    // back to the allocator, so devices coming and going in a loop (e.g.
+    // Bluetooth pads reconnecting) reuse the same memory
+    // everything is returned to the allocator when the pool is destroyed
+    // not thread-safe, only the thread owning the context may use it
+    struct memory_pool {
+        RB_NON_MOVEABLE(memory_pool);
+
+        explicit memory_pool(allocator);
+        ~memory_pool();
+
+        void* allocate(size_t);
+        void deallocate(void*, size_t);
+    private:
+        struct free_block {
+            free_block* m_next;
+        };
+
+        static constexpr size_t min_block_size = 16;
+        static constexpr size_t class_count = 11;
+        static constexpr size_t max_block_size = min_block_size << (class_count - 1);
+
+        static size_t class_of(size_t);
+        static size_t size_of_class(size_t);
+
+        allocator m_allocator;
+        std::array<free_block*, class_count> m_free;
+    };
+
+    // allocations that remember their pool and size, for operator new/delete overloads
+    void* pool_new(memory_pool&, size_t);
+    void pool_delete(void*);
+
+    // standard allocator adapter for containers owned by a context
+    template <typename T>
+    struct pool_allocator {
+        using value_type = T;
+
+        explicit pool_allocator(memory_pool& pool) : m_pool(&pool) {}
+
+        template <typename U>
+        pool_allocator(const pool_allocator<U>& other) : m_pool(other.m_pool) {}
+
+        T* allocate(size_t count) {
+            return static_cast<T*>(m_pool->allocate(count * sizeof(T)));
+        }
+
+        void deallocate(T* ptr, size_t count) {
+            m_pool->deallocate(ptr, count * sizeof(T));
+        }
+    private:
+        template <typename U>
+        friend struct pool_allocator;
+
+        template <typename U, typename V>
+        friend bool operator==(const pool_allocator<U>&, const pool_allocator<V>&);
+
+        memory_pool* m_pool;
+    };
+
+    template <typename U, typename V>
+    bool operator==(const pool_allocator<U>& a, const pool_allocator<V>& b) {
+        return a.m_pool == b.m_pool;
+    }
+
+    template <typename U, typename V>
+    bool operator!=(const pool_allocator<U>& a, const pool_allocator<V>& b) {
+        return !(a == b);
+    }
+}
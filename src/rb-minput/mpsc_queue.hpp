@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+#include "utils.hpp"
+
+namespace multi_input {
+    // lock-free multiple producer, single consumer queue
+    // producers push onto an intrusive stack, the consumer takes
+    // the whole stack at once and replays it in submission order
+    template <typename T>
+    struct mpsc_queue {
+        RB_NON_MOVEABLE(mpsc_queue);
+
+        mpsc_queue() : m_head(nullptr) {}
+
+        ~mpsc_queue() {
+            consume([](T&&) {});
+        }
+
+        void push(T value) {
+            auto item = new node{std::move(value), m_head.load(std::memory_order_relaxed)};
+
+            while (!m_head.compare_exchange_weak(item->m_next, item, std::memory_order_release, std::memory_order_relaxed)) {
+            }
+        }
+
+        bool empty() const {
+            return m_head.load(std::memory_order_acquire) == nullptr;
+        }
+
+        template <typename Fn>
+        void consume(Fn&& fn) {
+            auto head = m_head.exchange(nullptr, std::memory_order_acquire);
+
+            node* reversed = nullptr;
+            while (head != nullptr) {
+                auto next = head->m_next;
+                head->m_next = reversed;
+                reversed = head;
+                head = next;
+            }
+
+            while (reversed != nullptr) {
+                auto next = reversed->m_next;
+                fn(std::move(reversed->m_value));
+                delete reversed;
+                reversed = next;
+            }
+        }
+    private:
+        struct node {
+            T m_value;
+            node* m_next;
+        };
+
+        std::atomic<node*> m_head;
+    };
+}
@@ -172,7 +172,7 @@ namespace multi_input {
 
             RB_TRACE("creating new device object");
             auto id = m_ctx->get_next_id();
-            m_ctx->add_device(std::unique_ptr<device>{new hidm_device(m_ctx, id, name, handle)});
+            m_ctx->add_device(std::unique_ptr<device>{new (m_ctx) hidm_device(m_ctx, id, name, handle)});
             m_device_map.emplace(handle, id);
         }
 
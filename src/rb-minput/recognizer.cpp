@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#include <algorithm>
+
+#include "recognizer.hpp"
+#include "device.hpp"
+
+namespace multi_input {
+    namespace {
+        // tolerate clocks going backwards instead of wrapping around
+        event_time elapsed(event_time from, event_time to) {
+            return to > from ? to - from : 0;
+        }
+
+        bool within(event_time from, event_time to, event_time window) {
+            return window == 0 || elapsed(from, to) <= window;
+        }
+    }
+
+    recognizer::recognizer() :
+        m_next_id(1), m_patterns(), m_states(), m_matches()
+    {
+    }
+
+    api_int recognizer::add_pattern(pattern_kind kind, const pattern_step* steps, size_t count) {
+        pattern p{};
+        p.m_id = m_next_id++;
+        p.m_kind = kind;
+        p.m_length = count;
+
+        for (size_t idx = 0; idx < count; ++idx) {
+            auto slot = to_digital_slot(steps[idx].m_code);
+            auto window = static_cast<event_time>(steps[idx].m_window) * 1000;
+
+            p.m_slots[idx] = slot;
+            p.m_windows[idx] = window;
+            digital_channels::assign(p.m_mask, slot, true);
+
+            if (kind == pattern_kind::chord) {
+                p.m_windows[0] = std::max(p.m_windows[0], window);
+            }
+        }
+
+        if (kind == pattern_kind::sequence) {
+            size_t matched = 0;
+
+            for (size_t idx = 1; idx < count; ++idx) {
+                while (matched > 0 && p.m_slots[idx] != p.m_slots[matched]) {
+                    matched = p.m_fallback[matched];
+                }
+
+                if (p.m_slots[idx] == p.m_slots[matched]) {
+                    ++matched;
+                }
+
+                p.m_fallback[idx + 1] = matched;
+            }
+        }
+
+        m_patterns.emplace_back(p);
+        return p.m_id;
+    }
+
+    bool recognizer::remove_pattern(api_int id) {
+        auto it = std::find_if(m_patterns.begin(), m_patterns.end(), [&](const pattern& p) {
+            return p.m_id == id;
+        });
+
+        if (it == m_patterns.end()) {
+            return false;
+        }
+
+        auto index = static_cast<size_t>(it - m_patterns.begin());
+        m_patterns.erase(it);
+
+        for (auto&& pair : m_states) {
+            auto&& states = pair.second;
+
+            if (index < states.size()) {
+                states.erase(states.begin() + index);
+            }
+        }
+
+        return true;
+    }
+
+    void recognizer::remove_device(device_id id) {
+        m_states.erase(id);
+    }
+
+    void recognizer::clear_matches() {
+        m_matches.clear();
+    }
+
+    void recognizer::feed(device& dev) {
+        if (m_patterns.empty()) {
+            return;
+        }
+
+        auto&& digital = dev.get_digital();
+        auto&& log = digital.get_log();
+
+        if (log.empty()) {
+            return;
+        }
+
+        auto id = dev.get_id();
+        auto&& states = m_states[id];
+        states.resize(m_patterns.size(), state{});
+
+        // replay the transitions on top of the last committed state
+        auto held = digital.held();
+
+        for (auto&& transition : log) {
+            digital_channels::assign(held, transition.m_slot, transition.m_pressed);
+
+            if (!transition.m_pressed) {
+                continue;
+            }
+
+            for (size_t idx = 0; idx < m_patterns.size(); ++idx) {
+                auto&& p = m_patterns[idx];
+
+                if (!digital_channels::test(p.m_mask, transition.m_slot)) {
+                    continue;
+                }
+
+                switch (p.m_kind) {
+                    case pattern_kind::sequence:
+                        feed_sequence(p, states[idx], transition, id);
+                        break;
+                    case pattern_kind::chord:
+                        feed_chord(p, states[idx], transition, held, id);
+                        break;
+                }
+            }
+        }
+    }
+
+    void recognizer::feed_sequence(const pattern& p, state& s, const digital_transition& transition, device_id id) {
+        // on a mismatch the presses matched so far may still be the start of
+        // another attempt, e.g. A, A, A, B for A, A, B, so try the shorter
+        // prefixes they end with, longest first
+        auto step = s.m_step;
+        auto matched = false;
+
+        while (true) {
+            matched = p.m_slots[step] == transition.m_slot
+                && (step == 0 || within(s.m_last, transition.m_time, p.m_windows[step]))
+                && (step == s.m_step || fits_prefix(p, s, step));
+
+            if (matched || step == 0) {
+                break;
+            }
+
+            step = p.m_fallback[step];
+        }
+
+        if (matched) {
+            std::copy(s.m_times.begin() + (s.m_step - step), s.m_times.begin() + s.m_step, s.m_times.begin());
+            s.m_times[step] = transition.m_time;
+            s.m_step = step + 1;
+        } else {
+            s.m_step = 0;
+        }
+
+        s.m_last = transition.m_time;
+
+        if (s.m_step == p.m_length) {
+            m_matches.emplace_back(pattern_match{p.m_id, id});
+            s.m_step = 0;
+        }
+    }
+
+    bool recognizer::fits_prefix(const pattern& p, const state& s, size_t k) const {
+        auto offset = s.m_step - k;
+
+        for (size_t idx = 1; idx < k; ++idx) {
+            if (!within(s.m_times[offset + idx - 1], s.m_times[offset + idx], p.m_windows[idx])) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void recognizer::feed_chord(const pattern& p, state& s, const digital_transition& transition, const digital_bits& held, device_id id) {
+        for (size_t idx = 0; idx < p.m_length; ++idx) {
+            if (p.m_slots[idx] == transition.m_slot) {
+                s.m_times[idx] = transition.m_time;
+            }
+        }
+
+        auto first = transition.m_time;
+
+        for (size_t idx = 0; idx < p.m_length; ++idx) {
+            if (!digital_channels::test(held, p.m_slots[idx])) {
+                return;
+            }
+
+            first = std::min(first, s.m_times[idx]);
+        }
+
+        if (within(first, transition.m_time, p.m_windows[0])) {
+            m_matches.emplace_back(pattern_match{p.m_id, id});
+        }
+    }
+}
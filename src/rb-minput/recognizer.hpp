@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+#include "utils.hpp"
+#include "api_types.hpp"
+#include "input_code.hpp"
+#include "digital_channels.hpp"
+
+namespace multi_input {
+    struct device;
+
+    enum class pattern_kind {
+        // steps pressed one after another, e.g. motion inputs or multi-taps
+        sequence = 0,
+        // all steps held at once, pressed within the window
+        chord = 1,
+    };
+
+    // for sequences m_window is the max time (ms) since the previous step,
+    // for chords the largest window applies to the whole chord
+    // zero means no time limit
+    struct pattern_step {
+        input_code m_code;
+        api_int m_window;
+    };
+
+    struct pattern_match {
+        api_int m_pattern;
+        device_id m_device;
+    };
+
+    static_assert(std::is_pod<pattern_step>::value, "pattern_step must be a POD");
+    static_assert(std::is_pod<pattern_match>::value, "pattern_match must be a POD");
+
+    constexpr size_t max_pattern_steps = 16;
+
+    // matches declarative patterns against the timestamped digital transitions
+    // of every device, each (device, pattern) pair is a small state machine
+    // matches are collected per drain and read back in one batch
+    struct recognizer {
+        RB_MOVEABLE(recognizer);
+
+        recognizer();
+
+        // steps must be validated by the caller
+        api_int add_pattern(pattern_kind, const pattern_step*, size_t);
+        bool remove_pattern(api_int);
+        void remove_device(device_id);
+
+        void clear_matches();
+        void feed(device&);
+
+        const std::vector<pattern_match>& get_matches() const {
+            return m_matches;
+        }
+    private:
+        struct pattern {
+            api_int m_id;
+            pattern_kind m_kind;
+            size_t m_length;
+            std::array<size_t, max_pattern_steps> m_slots;
+            std::array<event_time, max_pattern_steps> m_windows;
+            // sequences only, the longest proper prefix of the first k steps
+            // that is also their suffix, where a mismatch after k steps
+            // resumes (KMP failure function)
+            std::array<size_t, max_pattern_steps + 1> m_fallback;
+            digital_bits m_mask;
+        };
+
+        struct state {
+            size_t m_step;
+            event_time m_last;
+            // press times of the steps matched so far
+            std::array<event_time, max_pattern_steps> m_times;
+        };
+
+        void feed_sequence(const pattern&, state&, const digital_transition&, device_id);
+        // whether the last k presses matched so far still keep the windows
+        // of the first k steps
+        bool fits_prefix(const pattern&, const state&, size_t k) const;
+        void feed_chord(const pattern&, state&, const digital_transition&, const digital_bits&, device_id);
+
+        api_int m_next_id;
+        std::vector<pattern> m_patterns;
+        std::unordered_map<device_id, std::vector<state>> m_states;
+        std::vector<pattern_match> m_matches;
+    };
+}
@@ -3,7 +3,10 @@
 
 #pragma once
 
+#include <vector>
+
 #include "utils.hpp"
+#include "api_types.hpp"
 
 namespace multi_input {
     struct context;
@@ -16,6 +19,19 @@ namespace multi_input {
 
         virtual void drain_events() = 0;
         virtual void enum_devices() = 0;
+
+        // reads events for the given devices only, ids of other sources are ignored
+        // sources that can't read devices separately drain everything, the other
+        // devices then keep the new state uncommitted until the next drain_events
+        virtual void drain_devices(const device_id*, size_t) {
+            drain_events();
+        }
+
+        // adds the descriptors that become readable when there are events to drain,
+        // returns true if events are already buffered so waiting would stall them
+        virtual bool get_wait_fds(std::vector<int>&) {
+            return false;
+        }
     protected:
         explicit source(context* ctx) : m_ctx(ctx) {}
 
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include "api_types.hpp"
+#include "input_code.hpp"
+
+namespace multi_input {
+    // bits of the source mask in options, sources of other platforms are ignored
+    enum class source_kind : int {
+        xi2 = 1,
+        evdev = 2,
+        raw_input = 4,
+        xinput = 8,
+        hidm = 16,
+    };
+
+    // bits of the device class mask in options
+    enum class device_class : int {
+        keyboard = 1,
+        mouse = 2,
+        gamepad = 4,
+    };
+
+    constexpr api_int all_sources = -1;
+    constexpr api_int all_device_classes = 7;
+
+    constexpr api_int operator|(device_class a, device_class b) {
+        return static_cast<api_int>(a) | static_cast<api_int>(b);
+    }
+
+    // the class of devices that report the given code, 0 for none
+    constexpr api_int device_class_of(input_code code) {
+        switch (get_category(code)) {
+            case input_category::keyboard: return static_cast<api_int>(device_class::keyboard);
+            case input_category::mouse:    return static_cast<api_int>(device_class::mouse);
+            case input_category::pad:      return static_cast<api_int>(device_class::gamepad);
+            default:                       return 0;
+        }
+    }
+}
@@ -0,0 +1,415 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#include <algorithm>
+
+#include "source_hub.hpp"
+#include "context.hpp"
+#include "device.hpp"
+#include "device_event.hpp"
+#include "axis_utils.hpp"
+
+namespace multi_input {
+    namespace {
+        // forwards to the hub device's target, holding the hub keeps the
+        // source that plays it alive
+        struct shared_haptics : haptics_target {
+            RB_NON_MOVEABLE(shared_haptics);
+
+            shared_haptics(std::shared_ptr<source_hub> hub, std::shared_ptr<haptics_target> target) :
+                m_hub(std::move(hub)), m_target(std::move(target))
+            {
+            }
+
+            virtual bool play(haptics_timeline timeline) override {
+                return m_target->play(std::move(timeline));
+            }
+        private:
+            std::shared_ptr<source_hub> m_hub;
+            std::shared_ptr<haptics_target> m_target;
+        };
+
+        // a hub device as seen by one context, haptics go back to the hub device
+        struct shared_device : device {
+            RB_NON_MOVEABLE(shared_device);
+
+            shared_device(context* ctx, device_id id, std::shared_ptr<source_hub> hub, device& source) :
+                device(ctx, id), m_hub(std::move(hub)), m_source(source.get_id()), m_can_vibrate(source.can_vibrate()), m_haptics()
+            {
+                auto target = source.get_haptics_target();
+                if (target != nullptr) {
+                    m_haptics = std::make_shared<shared_haptics>(m_hub, std::move(target));
+                }
+
+                copy_layout(source);
+                m_is_usable = source.is_usable();
+            }
+
+            virtual bool can_vibrate() const override {
+                return m_can_vibrate;
+            }
+
+            virtual bool vibrate(int duration, float left, float right) override {
+                std::lock_guard<std::mutex> lock{m_hub->get_mutex()};
+
+                auto source = m_hub->get_context().get_device(m_source);
+                return source != nullptr && source->vibrate(duration, left, right);
+            }
+
+            virtual std::shared_ptr<haptics_target> get_haptics_target() override {
+                return m_haptics;
+            }
+
+            // the journal carries raw values, so derive like the platform devices do
+            virtual void commit() override {
+                derive_stick_pre_commit(*this);
+                derive_mouse_pre_commit(*this);
+                device::commit();
+                derive_mouse_post_commit(*this);
+            }
+        private:
+            std::shared_ptr<source_hub> m_hub;
+            device_id m_source;
+            bool m_can_vibrate;
+            std::shared_ptr<haptics_target> m_haptics;
+        };
+    }
+
+    std::shared_ptr<source_hub> source_hub::acquire() {
+        static std::mutex mutex;
+        static std::weak_ptr<source_hub> instance;
+
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto hub = instance.lock();
+        if (hub == nullptr) {
+            hub.reset(new source_hub{});
+            instance = hub;
+        }
+
+        return hub;
+    }
+
+    source_hub::source_hub() :
+        m_mutex(), m_ctx(), m_caller(nullptr), m_cursors(), m_journal(), m_base(0), m_states()
+    {
+        options opts{};
+        opts.set_lazy_sources(true);
+        // the attached contexts filter with their own levels
+        opts.set_log_level(log_level::debug_verbose);
+        opts.set_custom_log_sink([this](log_level level, api_string message) {
+            if (m_caller != nullptr) {
+                m_caller->log(level, message);
+            }
+        });
+        opts.set_custom_device_callback([this](device_event event, device_id id, api_device*) {
+            on_device_event(event, id);
+        });
+
+        m_ctx = std::make_unique<context>(opts);
+    }
+
+    void source_hub::attach(hub_cursor& cursor, source_kind kind, context* caller) {
+        m_caller = caller;
+        m_ctx->open_source_kind(kind);
+        m_caller = nullptr;
+
+        // devices opened so far are picked up by enum_devices, not the journal
+        cursor.m_position = m_base + m_journal.size();
+        m_cursors.push_back(&cursor);
+    }
+
+    void source_hub::detach(hub_cursor& cursor) {
+        m_cursors.erase(std::remove(m_cursors.begin(), m_cursors.end(), &cursor), m_cursors.end());
+        trim();
+    }
+
+    void source_hub::pump(context* caller) {
+        m_caller = caller;
+        m_ctx->drain_sources();
+
+        m_ctx->for_each_device([&](device& dev) {
+            auto it = m_states.find(dev.get_id());
+            if (it != m_states.end()) {
+                journal(dev, it->second);
+            }
+        });
+
+        m_ctx->commit_devices();
+
+        m_ctx->for_each_device([&](device& dev) {
+            auto it = m_states.find(dev.get_id());
+            if (it != m_states.end()) {
+                publish(dev, it->second);
+            }
+        });
+
+        m_caller = nullptr;
+    }
+
+    bool source_hub::get_wait_fds(std::vector<int>& fds) {
+        return m_ctx->get_wait_fds(fds);
+    }
+
+    void source_hub::copy_state(device_id id, device& target) {
+        auto it = m_states.find(id);
+        if (it == m_states.end()) {
+            return;
+        }
+
+        auto&& state = it->second;
+
+        digital_channels::for_each(target.get_digital().present(), [&](size_t slot) {
+            target.get_axis(from_digital_slot(slot))->set(digital_channels::test(state.m_digital, slot) ? 1.0f : 0.0f);
+        });
+
+        for (size_t slot = 0; slot < analog_code_count; ++slot) {
+            auto code = from_analog_slot(slot);
+            auto axis = target.get_axis(code);
+
+            if (axis != nullptr && !is_relative_axis(code)) {
+                axis->set(state.m_analog[slot]);
+            }
+        }
+    }
+
+    void source_hub::on_device_event(device_event event, device_id id) {
+        switch (event) {
+            case device_event::created: {
+                auto dev = m_ctx->get_device(id);
+                if (dev == nullptr) {
+                    return;
+                }
+
+                auto&& state = m_states[id];
+                state = device_state{};
+                journal(*dev, state);
+                publish(*dev, state);
+
+                // the initial state is copied from the published one, not journaled
+                m_journal.erase(std::remove_if(m_journal.begin(), m_journal.end(), [&](const hub_entry& entry) {
+                    return entry.m_device == id;
+                }), m_journal.end());
+
+                push(hub_entry::type::added, id, input_code::none, 0, 0);
+                break;
+            }
+            case device_event::removed:
+                m_states.erase(id);
+                push(hub_entry::type::removed, id, input_code::none, 0, 0);
+                break;
+            case device_event::usable:
+                push(hub_entry::type::usable, id, input_code::none, 0, 0);
+                break;
+            case device_event::unusable:
+                push(hub_entry::type::unusable, id, input_code::none, 0, 0);
+                break;
+        }
+    }
+
+    void source_hub::push(hub_entry::type type, device_id id, input_code code, float value, event_time time) {
+        if (m_journal.size() >= max_journal_size) {
+            m_journal.pop_front();
+            ++m_base;
+        }
+
+        m_journal.push_back(hub_entry{type, id, code, value, time});
+    }
+
+    void source_hub::journal(device& dev, device_state& state) {
+        auto id = dev.get_id();
+        auto&& digital = dev.get_digital();
+        auto expected = state.m_digital;
+
+        for (auto&& transition : digital.get_log()) {
+            push(hub_entry::type::set, id, from_digital_slot(transition.m_slot), transition.m_pressed ? 1.0f : 0.0f, transition.m_time);
+            digital_channels::assign(expected, transition.m_slot, transition.m_pressed);
+        }
+
+        // device resets commit right away and never show up in the log
+        digital_channels::for_each(digital.present(), [&](size_t slot) {
+            auto next = digital.get_next(slot);
+
+            if (digital_channels::test(expected, slot) != next) {
+                push(hub_entry::type::set, id, from_digital_slot(slot), next ? 1.0f : 0.0f, digital.get_time());
+            }
+
+            digital_channels::assign(state.m_digital, slot, next);
+        });
+
+        for (size_t slot = 0; slot < analog_code_count; ++slot) {
+            auto code = from_analog_slot(slot);
+            auto axis = dev.get_axis(code);
+
+            if (axis == nullptr) {
+                continue;
+            }
+
+            auto value = axis->get_next();
+
+            if (is_relative_axis(code)) {
+                if (value != 0) {
+                    push(hub_entry::type::add, id, code, value, digital.get_time());
+                }
+            } else if (value != state.m_analog[slot]) {
+                push(hub_entry::type::set, id, code, value, digital.get_time());
+            }
+        }
+    }
+
+    void source_hub::publish(device& dev, device_state& state) {
+        // taken after the commit, so values derived there aren't journaled as changes
+        for (size_t slot = 0; slot < analog_code_count; ++slot) {
+            auto axis = dev.get_axis(from_analog_slot(slot));
+            state.m_analog[slot] = axis != nullptr ? axis->get_next() : 0;
+        }
+    }
+
+    void source_hub::trim() {
+        if (m_cursors.empty()) {
+            m_base += m_journal.size();
+            m_journal.clear();
+            return;
+        }
+
+        auto oldest = m_base + m_journal.size();
+        for (auto cursor : m_cursors) {
+            oldest = std::min(oldest, cursor->m_position);
+        }
+
+        while (m_base < oldest) {
+            m_journal.pop_front();
+            ++m_base;
+        }
+    }
+
+    hub_source::hub_source(context* ctx, source_kind kind) :
+        source(ctx), m_hub(source_hub::acquire()), m_kind(kind), m_cursor(), m_mirrors()
+    {
+        std::lock_guard<std::mutex> lock{m_hub->get_mutex()};
+        m_hub->attach(m_cursor, kind, ctx);
+    }
+
+    hub_source::~hub_source() {
+        std::lock_guard<std::mutex> lock{m_hub->get_mutex()};
+        m_hub->detach(m_cursor);
+    }
+
+    void hub_source::drain_events() {
+        std::lock_guard<std::mutex> lock{m_hub->get_mutex()};
+
+        m_hub->pump(m_ctx);
+
+        auto complete = m_hub->read(m_cursor, [&](const hub_entry& entry) {
+            apply(entry);
+        });
+
+        if (!complete) {
+            m_ctx->log_warning(u8"hub: context fell behind the shared sources, resynchronizing devices");
+            resync();
+        }
+    }
+
+    void hub_source::enum_devices() {
+        std::lock_guard<std::mutex> lock{m_hub->get_mutex()};
+
+        m_hub->get_context().for_each_device([&](device& dev) {
+            if (dev.get_source_kind() == static_cast<api_int>(m_kind) && m_mirrors.count(dev.get_id()) == 0) {
+                add_mirror(dev);
+            }
+        });
+    }
+
+    bool hub_source::get_wait_fds(std::vector<int>& fds) {
+        std::lock_guard<std::mutex> lock{m_hub->get_mutex()};
+
+        // another context may have drained what woke us up
+        auto buffered = m_hub->get_wait_fds(fds);
+        return buffered || m_hub->has_unread(m_cursor);
+    }
+
+    void hub_source::apply(const hub_entry& entry) {
+        switch (entry.m_type) {
+            case hub_entry::type::added: {
+                auto dev = m_hub->get_context().get_device(entry.m_device);
+                if (dev != nullptr && dev->get_source_kind() == static_cast<api_int>(m_kind) && m_mirrors.count(entry.m_device) == 0) {
+                    add_mirror(*dev);
+                }
+                return;
+            }
+            case hub_entry::type::removed: {
+                auto it = m_mirrors.find(entry.m_device);
+                if (it != m_mirrors.end()) {
+                    auto id = it->second;
+                    m_mirrors.erase(it);
+                    m_ctx->remove_device(id);
+                }
+                return;
+            }
+            default:
+                break;
+        }
+
+        auto it = m_mirrors.find(entry.m_device);
+        if (it == m_mirrors.end()) {
+            return;
+        }
+
+        auto mirror = m_ctx->get_device(it->second);
+        if (mirror == nullptr) {
+            return;
+        }
+
+        switch (entry.m_type) {
+            case hub_entry::type::usable:
+                mirror->set_usable(true);
+                break;
+            case hub_entry::type::unusable:
+                mirror->set_usable(false);
+                break;
+            case hub_entry::type::set:
+            case hub_entry::type::add: {
+                auto axis = mirror->get_axis(entry.m_code);
+                if (axis == nullptr) {
+                    break;
+                }
+
+                mirror->set_event_time(entry.m_time);
+                // refetched so analog writes get the entry's time
+                axis = mirror->get_axis(entry.m_code);
+
+                if (entry.m_type == hub_entry::type::set) {
+                    axis->set(entry.m_value);
+                } else {
+                    axis->add(entry.m_value);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void hub_source::add_mirror(device& source) {
+        auto id = m_ctx->get_next_id();
+        auto mirror = new (m_ctx) shared_device(m_ctx, id, m_hub, source);
+        m_hub->copy_state(source.get_id(), *mirror);
+
+        m_mirrors.emplace(source.get_id(), id);
+        m_ctx->add_device(std::unique_ptr<device>{mirror});
+    }
+
+    void hub_source::resync() {
+        for (auto&& pair : m_mirrors) {
+            m_ctx->remove_device(pair.second);
+        }
+
+        m_mirrors.clear();
+
+        m_hub->get_context().for_each_device([&](device& dev) {
+            if (dev.get_source_kind() == static_cast<api_int>(m_kind)) {
+                add_mirror(dev);
+            }
+        });
+    }
+}
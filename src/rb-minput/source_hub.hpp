@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "utils.hpp"
+#include "api_types.hpp"
+#include "input_code.hpp"
+#include "digital_channels.hpp"
+#include "source.hpp"
+#include "source_flags.hpp"
+
+namespace multi_input {
+    struct context;
+    struct device;
+
+    // one drained change of a hub device
+    struct hub_entry {
+        enum class type : uint8_t {
+            added,
+            removed,
+            usable,
+            unusable,
+            // absolute value
+            set,
+            // relative axes (mouse motion) accumulate until the mirror commits
+            add,
+        };
+
+        type m_type;
+        device_id m_device;
+        input_code m_code;
+        float m_value;
+        event_time m_time;
+    };
+
+    // position of one attached source in the hub's journal
+    struct hub_cursor {
+        uint64_t m_position;
+    };
+
+    // process-wide owner of the platform sources for contexts created with
+    // shared sources: devices are read once into the hub's own context and
+    // every drained change is journaled before the hub commits, so each
+    // attached context replays the journal at its own commit cadence
+    // everything except acquire must be called with the mutex held
+    struct source_hub {
+        RB_NON_MOVEABLE(source_hub);
+
+        // the hub lives as long as a context uses it
+        static std::shared_ptr<source_hub> acquire();
+
+        std::mutex& get_mutex() {
+            return m_mutex;
+        }
+
+        context& get_context() {
+            return *m_ctx;
+        }
+
+        // opens the source kind if no context did yet, log messages of the
+        // hub go to the context that triggered them
+        void attach(hub_cursor&, source_kind, context*);
+        void detach(hub_cursor&);
+
+        // reads all opened sources, journals the changes and commits
+        void pump(context*);
+        bool get_wait_fds(std::vector<int>&);
+
+        // calls fn for every entry after the cursor and moves it to the end,
+        // false if entries were dropped because the cursor lagged too far behind
+        template <typename Fn>
+        bool read(hub_cursor& cursor, Fn&& fn) {
+            auto complete = cursor.m_position >= m_base;
+            auto position = complete ? cursor.m_position : m_base;
+
+            for (auto idx = static_cast<size_t>(position - m_base); idx < m_journal.size(); ++idx) {
+                fn(m_journal[idx]);
+            }
+
+            cursor.m_position = m_base + m_journal.size();
+            trim();
+            return complete;
+        }
+
+        bool has_unread(const hub_cursor& cursor) const {
+            return cursor.m_position < m_base + m_journal.size();
+        }
+
+        // the published (last journaled) state of a hub device, for new mirrors
+        void copy_state(device_id, device&);
+    private:
+        struct device_state {
+            digital_bits m_digital;
+            std::array<float, analog_code_count> m_analog;
+        };
+
+        // the journal is capped, lagging contexts resynchronize
+        static constexpr size_t max_journal_size = 1 << 16;
+
+        source_hub();
+
+        void on_device_event(device_event, device_id);
+        void push(hub_entry::type, device_id, input_code, float, event_time);
+        void journal(device&, device_state&);
+        void publish(device&, device_state&);
+        void trim();
+
+        std::mutex m_mutex;
+        std::unique_ptr<context> m_ctx;
+        context* m_caller;
+        std::vector<hub_cursor*> m_cursors;
+        std::deque<hub_entry> m_journal;
+        uint64_t m_base;
+        std::unordered_map<device_id, device_state> m_states;
+    };
+
+    // mirrors the hub devices of one source kind into its context
+    struct hub_source : source {
+        RB_NON_MOVEABLE(hub_source);
+
+        hub_source(context*, source_kind);
+        virtual ~hub_source();
+
+        virtual void drain_events() override;
+        virtual void enum_devices() override;
+        virtual bool get_wait_fds(std::vector<int>&) override;
+    private:
+        void apply(const hub_entry&);
+        void add_mirror(device&);
+        void resync();
+
+        std::shared_ptr<source_hub> m_hub;
+        source_kind m_kind;
+        hub_cursor m_cursor;
+        // hub device id to mirror id
+        std::unordered_map<device_id, device_id> m_mirrors;
+    };
+
+    // context sources are created from the context alone
+    template <source_kind Kind>
+    struct hub_source_for : hub_source {
+        explicit hub_source_for(context* ctx) : hub_source(ctx, Kind) {}
+    };
+}
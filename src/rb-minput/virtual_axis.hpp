@@ -3,23 +3,38 @@
 
 #pragma once
 
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include "utils.hpp"
+#include "digital_channels.hpp"
+#include "memory.hpp"
+
 namespace multi_input {
     struct virtual_axis {
         RB_COPYABLE(virtual_axis);
 
-        virtual_axis() : m_current(0), m_previous(0), m_next(0) {}
+        virtual_axis() : m_current(0), m_previous(0), m_next(0), m_changed(0), m_changed_next(0) {}
 
-        void set(float value) {
-            m_next = value;
+        void set(float value, event_time time) {
+            if (value != m_next) {
+                m_next = value;
+                m_changed_next = time;
+            }
         }
 
-        void add(float value) {
-            m_next += value;
+        void add(float value, event_time time) {
+            if (value != 0) {
+                m_next += value;
+                m_changed_next = time;
+            }
         }
 
         void commit() {
             m_previous = m_current;
             m_current = m_next;
+            m_changed = m_changed_next;
         }
 
         float get() const {
@@ -33,9 +48,229 @@ namespace multi_input {
         float get_next() const {
             return m_next;
         }
+
+        // timestamp of the event that last changed the committed value
+        event_time get_changed() const {
+            return m_changed;
+        }
+
+        event_time get_changed_next() const {
+            return m_changed_next;
+        }
+
+        // puts back the uncommitted value an analog_change replaced
+        void restore(float value, event_time time) {
+            m_next = value;
+            m_changed_next = time;
+        }
     private:
         float m_current;
         float m_previous;
         float m_next;
+        event_time m_changed;
+        event_time m_changed_next;
+    };
+
+    // one uncommitted write to an analog axis, kept by the device until
+    // its next commit so the writes can be taken back and replayed
+    struct analog_change {
+        virtual_axis* m_axis;
+        input_code m_code;
+        bool m_add;
+        float m_value;
+        event_time m_time;
+        float m_old;
+        event_time m_old_time;
+    };
+
+    // the analog_changes of a device, only the slicer reads them, so they
+    // are recorded only while the context slices its drains
+    struct analog_log {
+        RB_NON_MOVEABLE(analog_log);
+
+        using change_list = std::vector<analog_change, pool_allocator<analog_change>>;
+
+        explicit analog_log(memory_pool& pool) : m_recording(false), m_changes(pool_allocator<analog_change>{pool}) {}
+
+        bool is_recording() const {
+            return m_recording;
+        }
+
+        // stopping drops what was recorded
+        void set_recording(bool recording) {
+            m_recording = recording;
+
+            if (!recording) {
+                m_changes.clear();
+            }
+        }
+
+        void push(const analog_change& change) {
+            m_changes.push_back(change);
+        }
+
+        change_list& get_changes() {
+            return m_changes;
+        }
+
+        void clear() {
+            m_changes.clear();
+        }
+    private:
+        bool m_recording;
+        change_list m_changes;
+    };
+
+    // handle to a single input code on a device, either an analog virtual_axis
+    // or a bit in the device's digital_channels
+    // behaves like a nullable pointer so callers can keep using axis->set(...)
+    struct axis_ref {
+        RB_COPYABLE(axis_ref);
+
+        axis_ref() : m_analog(nullptr), m_digital(nullptr), m_slot(no_digital_slot), m_time(0), m_code(input_code::none), m_log(nullptr) {}
+        axis_ref(std::nullptr_t) : axis_ref() {}
+        axis_ref(virtual_axis* analog, event_time time, input_code code, analog_log* log) :
+            m_analog(analog), m_digital(nullptr), m_slot(no_digital_slot), m_time(time), m_code(code), m_log(log) {}
+        axis_ref(digital_channels* digital, size_t slot) :
+            m_analog(nullptr), m_digital(digital), m_slot(slot), m_time(0), m_code(input_code::none), m_log(nullptr) {}
+
+        axis_ref* operator->() {
+            return this;
+        }
+
+        const axis_ref* operator->() const {
+            return this;
+        }
+
+        explicit operator bool() const {
+            return m_analog != nullptr || m_digital != nullptr;
+        }
+
+        bool operator==(std::nullptr_t) const {
+            return !static_cast<bool>(*this);
+        }
+
+        bool operator!=(std::nullptr_t) const {
+            return static_cast<bool>(*this);
+        }
+
+        bool is_digital() const {
+            return m_digital != nullptr;
+        }
+
+        // for refs kept across reports, analog writes are stamped with it
+        void set_time(event_time time) {
+            m_time = time;
+        }
+
+        void set(float value) {
+            if (m_digital != nullptr) {
+                m_digital->set(m_slot, value != 0);
+            } else {
+                assert(m_analog != nullptr);
+                if (m_log != nullptr && m_log->is_recording() && value != m_analog->get_next()) {
+                    record(false, value);
+                }
+
+                m_analog->set(value, m_time);
+            }
+        }
+
+        void add(float value) {
+            if (m_digital != nullptr) {
+                set(get_next() + value);
+            } else {
+                assert(m_analog != nullptr);
+                if (m_log != nullptr && m_log->is_recording() && value != 0) {
+                    record(true, value);
+                }
+
+                m_analog->add(value, m_time);
+            }
+        }
+
+        void commit() {
+            if (m_digital != nullptr) {
+                m_digital->commit(m_slot);
+            } else {
+                assert(m_analog != nullptr);
+                m_analog->commit();
+            }
+        }
+
+        float get() const {
+            if (m_digital != nullptr) {
+                return m_digital->get(m_slot) ? 1.0f : 0.0f;
+            }
+
+            assert(m_analog != nullptr);
+            return m_analog->get();
+        }
+
+        float get_previous() const {
+            if (m_digital != nullptr) {
+                return m_digital->get_previous(m_slot) ? 1.0f : 0.0f;
+            }
+
+            assert(m_analog != nullptr);
+            return m_analog->get_previous();
+        }
+
+        float get_next() const {
+            if (m_digital != nullptr) {
+                return m_digital->get_next(m_slot) ? 1.0f : 0.0f;
+            }
+
+            assert(m_analog != nullptr);
+            return m_analog->get_next();
+        }
+
+        // analog axes don't track transitions, they report the rest state edge
+        int get_presses() const {
+            if (m_digital != nullptr) {
+                return m_digital->get_presses(m_slot);
+            }
+
+            assert(m_analog != nullptr);
+            return m_analog->get() != 0 && m_analog->get_previous() == 0 ? 1 : 0;
+        }
+
+        int get_releases() const {
+            if (m_digital != nullptr) {
+                return m_digital->get_releases(m_slot);
+            }
+
+            assert(m_analog != nullptr);
+            return m_analog->get() == 0 && m_analog->get_previous() != 0 ? 1 : 0;
+        }
+
+        event_time get_changed() const {
+            if (m_digital != nullptr) {
+                return m_digital->get_changed(m_slot);
+            }
+
+            assert(m_analog != nullptr);
+            return m_analog->get_changed();
+        }
+    private:
+        void record(bool add, float value) {
+            m_log->push(analog_change{m_analog, m_code, add, value, m_time, m_analog->get_next(), m_analog->get_changed_next()});
+        }
+
+        virtual_axis* m_analog;
+        digital_channels* m_digital;
+        size_t m_slot;
+        // analog writes are stamped with the device event time at lookup
+        event_time m_time;
+        input_code m_code;
+        analog_log* m_log;
     };
+
+    inline bool operator==(std::nullptr_t, const axis_ref& ref) {
+        return ref == nullptr;
+    }
+
+    inline bool operator!=(std::nullptr_t, const axis_ref& ref) {
+        return ref != nullptr;
+    }
 }
@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#include "virtual_device.hpp"
+#include "axis_utils.hpp"
+#include "context.hpp"
+
+namespace multi_input {
+    namespace {
+        struct derived_codes {
+            input_code m_source;
+            input_code m_first;
+            input_code m_second;
+        };
+
+        // the axis pair filled in from the source on commit
+        constexpr derived_codes derived_halves[] = {
+            { input_code::mouse_x, input_code::mouse_x_left, input_code::mouse_x_right },
+            { input_code::mouse_y, input_code::mouse_y_down, input_code::mouse_y_up },
+            { input_code::mouse_wheel, input_code::mouse_wheel_down, input_code::mouse_wheel_up },
+            { input_code::pad_left_stick_x, input_code::pad_left_stick_left, input_code::pad_left_stick_right },
+            { input_code::pad_left_stick_y, input_code::pad_left_stick_down, input_code::pad_left_stick_up },
+            { input_code::pad_right_stick_x, input_code::pad_right_stick_left, input_code::pad_right_stick_right },
+            { input_code::pad_right_stick_y, input_code::pad_right_stick_down, input_code::pad_right_stick_up },
+        };
+
+        // the source filled in from the button pair on commit
+        constexpr derived_codes derived_axes[] = {
+            { input_code::pad_dpad_x, input_code::pad_dpad_left, input_code::pad_dpad_right },
+            { input_code::pad_dpad_y, input_code::pad_dpad_down, input_code::pad_dpad_up },
+        };
+    }
+
+    virtual_device::virtual_device(context* ctx, device_id id, const virtual_device_desc& desc) :
+        device(ctx, id)
+    {
+        auto& meta = get_meta();
+        meta.set_name(desc.m_name != nullptr ? desc.m_name : "Virtual device");
+        meta.set_internal_id(format("virtual:%1%", id));
+        meta.set_serial(desc.m_serial != nullptr ? desc.m_serial : "");
+        meta.set_ids(desc.m_vendor_id, desc.m_product_id, desc.m_revision);
+
+        for (size_t idx = 0; idx < desc.m_code_count; ++idx) {
+            add_axis(desc.m_codes[idx]);
+        }
+
+        for (auto&& codes : derived_halves) {
+            if (get_axis(codes.m_source) != nullptr) {
+                add_axis(codes.m_first);
+                add_axis(codes.m_second);
+            }
+        }
+
+        for (auto&& codes : derived_axes) {
+            if (get_axis(codes.m_first) != nullptr && get_axis(codes.m_second) != nullptr) {
+                add_axis(codes.m_source);
+            }
+        }
+    }
+
+    size_t virtual_device::inject(const virtual_event* events, size_t count) {
+        size_t applied = 0;
+        auto now = steady_now();
+        event_time reported = 0;
+
+        for (size_t idx = 0; idx < count; ++idx) {
+            auto&& event = events[idx];
+            auto time = event.m_time != 0 ? event.m_time : now;
+
+            // the time is taken when the axis is fetched
+            set_event_time(time);
+            auto axis = get_axis(event.m_code);
+            if (axis == nullptr) {
+                continue;
+            }
+
+            // events sharing a timestamp count as one report, like a SYN_REPORT batch
+            if (time != reported) {
+                m_latency.record_report(time);
+                reported = time;
+            }
+
+            if (is_relative_axis(event.m_code)) {
+                axis->add(event.m_value);
+            } else {
+                axis->set(event.m_value);
+            }
+
+            ++applied;
+        }
+
+        if (applied > 0) {
+            m_ctx->mark_buffered();
+        }
+
+        return applied;
+    }
+
+    void virtual_device::commit() {
+        derive_stick_pre_commit(*this);
+        derive_mouse_pre_commit(*this);
+        device::commit();
+        derive_mouse_post_commit(*this);
+    }
+}
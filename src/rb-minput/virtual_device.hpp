@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+#pragma once
+
+#include "utils.hpp"
+#include "api_types.hpp"
+#include "device.hpp"
+
+namespace multi_input {
+    // layout of a device created by the application, the codes may
+    // include duplicates and input_code::none, both are ignored
+    struct virtual_device_desc {
+        api_string m_name;
+        api_string m_serial;
+        api_int m_vendor_id;
+        api_int m_product_id;
+        api_int m_revision;
+        const input_code* m_codes;
+        size_t m_code_count;
+    };
+
+    // one injected change, applied in order before the next commit
+    // relative axes (mouse motion) accumulate, every other code is set,
+    // a time of 0 stands for the moment of injection
+    struct virtual_event {
+        input_code m_code;
+        api_float m_value;
+        event_time m_time;
+    };
+
+    static_assert(std::is_pod<virtual_device_desc>::value, "virtual_device_desc must be a POD");
+    static_assert(std::is_pod<virtual_event>::value, "virtual_event must be a POD");
+
+    // takes raw values like the platform devices do: mouse Y grows downwards
+    // and the derived axes (stick directions, dpad, mouse halves) are added
+    // and filled in on commit
+    struct virtual_device : device {
+        RB_NON_MOVEABLE(virtual_device);
+
+        virtual_device(context*, device_id, const virtual_device_desc&);
+
+        // returns the number of events applied, codes the device lacks are skipped
+        size_t inject(const virtual_event*, size_t);
+
+        virtual void commit() override;
+    };
+}
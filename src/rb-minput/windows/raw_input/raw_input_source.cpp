@@ -204,7 +204,7 @@ namespace multi_input {
 
             RB_TRACE("creating new device object");
             auto id = m_ctx->get_next_id();
-            m_ctx->add_device(std::unique_ptr<device>{new raw_input_device(m_ctx, id, handle, info, device_info)});
+            m_ctx->add_device(std::unique_ptr<device>{new (m_ctx) raw_input_device(m_ctx, id, handle, info, device_info)});
             m_device_map.emplace(handle, id);
         }
 
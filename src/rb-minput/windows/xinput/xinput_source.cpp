@@ -26,7 +26,7 @@ namespace multi_input {
             for (int index = 0; index < 4; index++) {
                 RB_TRACE("creating new device object");
                 auto id = m_ctx->get_next_id();
-                m_ctx->add_device(std::unique_ptr<device>{new xinput_device(m_ctx, id, index)});
+                m_ctx->add_device(std::unique_ptr<device>{new (m_ctx) xinput_device(m_ctx, id, index)});
                 m_devices[index] = static_cast<xinput_device*>(m_ctx->get_device(id));
             }
 
@@ -3,8 +3,13 @@
 
 #define RB_USE_LIB
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
 #include <iostream>
 #include <iomanip>
+#include <new>
 #include <stdexcept>
 #include <string>
 
@@ -20,6 +25,8 @@
 
 #include "api.hpp"
 #include "device.hpp"
+#include "recognizer.hpp"
+#include "virtual_device.hpp"
 #include "enums.hpp"
 
 using namespace multi_input;
@@ -66,6 +73,45 @@ void sleep_ms(int ms) {
 
 std::string g_rumble_name;
 
+// --count-allocations: every heap allocation made while g_counting is set
+// is counted, including the ones made inside the library
+std::atomic<bool> g_counting{false};
+std::atomic<size_t> g_heap_allocations{0};
+std::atomic<size_t> g_pool_allocations{0};
+
+void* operator new(size_t size) {
+    if (g_counting) {
+        ++g_heap_allocations;
+    }
+
+    auto ptr = std::malloc(size > 0 ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc{};
+    }
+
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+RB_APICALL_PRE void* RB_APICALL_POST counting_alloc(user_data, size_t size, size_t) {
+    if (g_counting) {
+        ++g_pool_allocations;
+    }
+
+    return std::malloc(size);
+}
+
+RB_APICALL_PRE void RB_APICALL_POST counting_free(user_data, void* ptr, size_t) {
+    std::free(ptr);
+}
+
 template <typename Fn>
 void enumerate_devices(context *ctx, Fn&& fn) {
     auto enum_ = rb_minput_get_devices(ctx);
@@ -137,9 +183,130 @@ RB_APICALL_PRE void RB_APICALL_POST on_device_event(user_data, device_event even
     }
 }
 
+// everything a game would do every frame, none of it may allocate
+void run_frame(context *ctx) {
+    static std::array<input_code, 1024> axes{};
+    static std::array<input_code, 64> edges{};
+    static std::array<pattern_match, 16> matches{};
+
+    drain_system_events();
+    ensure(rb_minput_drain_events(ctx));
+
+    device_id first_id;
+    input_code first_axis{};
+    rb_minput_find_first(ctx, any_non_zero, nullptr, nullptr, 0, &first_id, &first_axis);
+    rb_minput_get_matches(ctx, matches.data(), matches.size());
+
+    enumerate_devices(ctx, [&](context*, api_device& info) {
+        auto count = std::min(rb_minput_get_axis_count(ctx, info.m_id), axes.size());
+
+        if (count == 0 || !info.m_is_usable) {
+            return;
+        }
+
+        ensure(rb_minput_get_axes(ctx, info.m_id, axes.data(), count));
+        for (size_t idx = 0; idx < count; ++idx) {
+            float current, previous, next;
+            ensure(rb_minput_get_values(ctx, info.m_id, axes[idx], &current, &previous, &next));
+        }
+
+        rb_minput_any_held(ctx, info.m_id);
+        rb_minput_get_pressed(ctx, info.m_id, edges.data(), edges.size());
+        rb_minput_get_released(ctx, info.m_id, edges.data(), edges.size());
+    });
+}
+
+// a keyboard, a mouse and a gamepad made up by the test, so the device
+// paths are exercised on machines without any input devices
+struct synthetic_device {
+    const char *m_name;
+    std::array<input_code, 6> m_codes;
+    device_id m_id;
+};
+
+std::array<synthetic_device, 3> g_synthetic{{
+    { "synthetic keyboard", {{ input_code::key_a, input_code::key_d, input_code::key_space, input_code::key_left_shift, input_code::key_enter, input_code::key_escape }}, 0 },
+    { "synthetic mouse", {{ input_code::mouse_x, input_code::mouse_y, input_code::mouse_left, input_code::mouse_right, input_code::mouse_wheel, input_code::mouse_middle }}, 0 },
+    { "synthetic gamepad", {{ input_code::pad_left_stick_x, input_code::pad_left_stick_y, input_code::pad_a, input_code::pad_b, input_code::pad_left_trigger, input_code::pad_dpad_left }}, 0 },
+}};
+
+void create_synthetic_devices(context *ctx) {
+    for (auto&& synthetic : g_synthetic) {
+        virtual_device_desc desc{synthetic.m_name, "", 0, 0, 0, synthetic.m_codes.data(), synthetic.m_codes.size()};
+
+        synthetic.m_id = rb_minput_create_virtual_device(ctx, &desc);
+        ensure(synthetic.m_id != 0);
+    }
+}
+
+// presses and releases every button and sweeps the analog axes
+void inject_synthetic_events(context *ctx, int frame) {
+    std::array<virtual_event, 6> events{};
+
+    for (auto&& synthetic : g_synthetic) {
+        for (size_t idx = 0; idx < synthetic.m_codes.size(); ++idx) {
+            auto pressed = (frame + static_cast<int>(idx)) % 2 == 0;
+            auto sweep = static_cast<float>((frame + static_cast<int>(idx)) % 21 - 10) / 10.0f;
+            auto code = synthetic.m_codes[idx];
+            auto analog = code == input_code::mouse_x || code == input_code::mouse_y || code == input_code::mouse_wheel
+                || code == input_code::pad_left_stick_x || code == input_code::pad_left_stick_y;
+
+            events[idx] = virtual_event{code, analog ? sweep : (pressed ? 1.0f : 0.0f), 0};
+        }
+
+        ensure(rb_minput_inject(ctx, synthetic.m_id, events.data(), events.size()) == events.size());
+    }
+}
+
+int count_allocations(context *ctx, int frames) {
+    create_synthetic_devices(ctx);
+
+    // a device without axes would make every query below a no-op
+    auto devices = 0;
+    auto with_axes = 0;
+
+    enumerate_devices(ctx, [&](context*, api_device& info) {
+        ++devices;
+        if (rb_minput_get_axis_count(ctx, info.m_id) > 0) {
+            ++with_axes;
+        }
+    });
+
+    if (with_axes == 0) {
+        std::cout << "** Error: no device has any axes, nothing would be checked\n";
+        return 1;
+    }
+
+    if (devices == static_cast<int>(g_synthetic.size())) {
+        std::cout << "** Warning: no platform devices found, only the synthetic ones are driven\n" << std::flush;
+    }
+
+    // warm up caches, pools and lazily grown buffers first
+    for (auto idx = 0; idx < frames; ++idx) {
+        inject_synthetic_events(ctx, idx);
+        run_frame(ctx);
+        sleep_ms(10);
+    }
+
+    g_counting = true;
+    for (auto idx = 0; idx < frames; ++idx) {
+        inject_synthetic_events(ctx, idx);
+        run_frame(ctx);
+        sleep_ms(10);
+    }
+    g_counting = false;
+
+    std::cout << "==[ Allocations over " << frames << " frames ]==\n";
+    std::cout << "\tHeap: " << g_heap_allocations << "\n";
+    std::cout << "\tPool: " << g_pool_allocations << "\n" << std::flush;
+
+    return g_heap_allocations == 0 && g_pool_allocations == 0 ? 0 : 1;
+}
+
 int main(int argc, char **argv) {
     std::vector<std::string> args{};
     auto no_loop = false;
+    auto count_frames = 0;
 
     for (auto idx = 1; idx < argc; ++idx) {
         args.emplace_back(argv[idx]);
@@ -155,14 +322,28 @@ int main(int argc, char **argv) {
             g_rumble_name = *it;
         } else if (*it == "--no-loop") {
             no_loop = true;
+        } else if (*it == "--count-allocations") {
+            if (++it == args.end()) {
+                std::cout << "** Error: --count-allocations requires an argument\n";
+                return 1;
+            }
+
+            count_frames = std::stoi(*it);
         }
     }
 
     auto opts = rb_minput_create_options();
     ensure(opts);
-    ensure(rb_minput_set_log_level(opts, log_level::debug_verbose));
     ensure(rb_minput_set_stderr_log_sink(opts));
-    ensure(rb_minput_set_device_callback(opts, on_device_event, nullptr));
+
+    if (count_frames > 0) {
+        // logging formats messages on the heap, keep it quiet
+        ensure(rb_minput_set_log_level(opts, log_level::warning));
+        ensure(rb_minput_set_allocator(opts, counting_alloc, counting_free, nullptr));
+    } else {
+        ensure(rb_minput_set_log_level(opts, log_level::debug_verbose));
+        ensure(rb_minput_set_device_callback(opts, on_device_event, nullptr));
+    }
 
     auto ctx = rb_minput_create(opts);
     ensure(ctx);
@@ -171,6 +352,10 @@ int main(int argc, char **argv) {
     std::cout << "==[ Initial enumeration ]==\n" << std::flush;
     enumerate_devices(ctx, print_info);
 
+    if (count_frames > 0) {
+        return count_allocations(ctx, count_frames);
+    }
+
     if (no_loop) {
         return 0;
     }
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+using System;
+using System.Diagnostics.CodeAnalysis;
+
+namespace RavingBots.MultiInput
+{
+	/// <summary>
+	///     Device classes that can be enabled with <see cref="Native.SetDeviceClasses" />.
+	///     A source is opened only if it provides at least one enabled class.
+	/// </summary>
+	[Flags]
+	[SuppressMessage("ReSharper", "UnusedMember.Global")]
+	public enum DeviceClass
+	{
+		// TODO sync with source_flags.hpp
+		/// <summary>
+		///     Keyboards.
+		/// </summary>
+		Keyboard = 1,
+
+		/// <summary>
+		///     Mice.
+		/// </summary>
+		Mouse = 2,
+
+		/// <summary>
+		///     Gamepads.
+		/// </summary>
+		Gamepad = 4,
+
+		/// <summary>
+		///     Every device class.
+		/// </summary>
+		All = Keyboard | Mouse | Gamepad
+	}
+}
@@ -16,7 +16,7 @@ namespace RavingBots.MultiInput
 	///     </para>
 	///     <para>
 	///         Not all codes present here will actually
-	///         be reported � it highly depends on what the OS and the actual device supports. You should
+	///         be reported - it highly depends on what the OS and the actual device supports. You should
 	///         keep that in mind when determining default controls for your game.
 	///     </para>
 	///     <note type="important">
@@ -66,7 +66,7 @@ namespace RavingBots.MultiInput
 	///         Axes representing digital buttons always report 0 or 1 value. Other axes will report scalar floating point
 	///         values.
 	///         The range of analog axis values depends on the axis (for example <see cref="MouseX" /> range is unbounded, and
-	///         <see cref="PadLeftStickX" /> range is <c>[-1, 1]</c>) � see the description of the enumerator for details.
+	///         <see cref="PadLeftStickX" /> range is <c>[-1, 1]</c>) - see the description of the enumerator for details.
 	///         Range notation has been used throughout this document as a shorthand:
 	///     </para>
 	///     <list type="bullet">
@@ -80,20 +80,8 @@ namespace RavingBots.MultiInput
 	[SuppressMessage("ReSharper", "UnusedMember.Global")]
 	public enum InputCode
 	{
-		// TODO this needs to be generated from input_code.hpp
-		// MAINTAINER NOTE:
-		// This enumeration needs to be serialization-friendly.
-		// (ranges are inclusive)
-		//
-		// - Keyboard range is 100000 to 149999 (reserved custom 150000-199999)
-		// - Mouse range is 200000 to 249999 (reserved custom 250000-299999)
-		// - Gamepad range is 300000 to 349999 (reserved custom 350000-399999)
-		// - Always add new values at the end of the respective range
-		// - Never reuse numeric values
-		// - Never remove enumerators
-		// - Never rename enumerators
-		// - Never change numeric values of existing enumerators
-		// - Never assign values from reserved subranges
+		// generated by src/codegen/input_codes.py from src/codegen/input_codes.txt, do not edit
+		// see input_codes.txt for the rules on adding codes
 
 		/// <summary>
 		///     Value reserved for unknown codes or uninitialized variables.
@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+using System.Diagnostics.CodeAnalysis;
+
+namespace RavingBots.MultiInput
+{
+	/// <summary>
+	///     Kinds of input patterns recognized natively.
+	/// </summary>
+	[SuppressMessage("ReSharper", "UnusedMember.Global")]
+	public enum PatternKind
+	{
+		// TODO sync with recognizer.hpp
+		/// <summary>
+		///     Steps pressed one after another, each within its window of the previous one
+		///     (e.g. motion inputs or double-taps).
+		/// </summary>
+		Sequence = 0,
+
+		/// <summary>
+		///     All steps held at the same time, pressed within the largest window of each other.
+		/// </summary>
+		Chord = 1
+	}
+}
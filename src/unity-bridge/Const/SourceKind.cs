@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2016-2024 Raving Bots
+
+using System;
+using System.Diagnostics.CodeAnalysis;
+
+namespace RavingBots.MultiInput
+{
+	/// <summary>
+	///     Native input sources that can be enabled with <see cref="Native.SetSources" />.
+	///     Sources of other platforms are ignored.
+	/// </summary>
+	[Flags]
+	[SuppressMessage("ReSharper", "UnusedMember.Global")]
+	public enum SourceKind
+	{
+		// TODO sync with source_flags.hpp
+		/// <summary>
+		///     Enables every source of the platform.
+		/// </summary>
+		All = -1,
+
+		/// <summary>
+		///     Linux X11 XInput2 keyboards and mice.
+		/// </summary>
+		Xi2 = 1,
+
+		/// <summary>
+		///     Linux evdev gamepads.
+		/// </summary>
+		Evdev = 2,
+
+		/// <summary>
+		///     Windows Raw Input keyboards and mice.
+		/// </summary>
+		RawInput = 4,
+
+		/// <summary>
+		///     Windows XInput gamepads.
+		/// </summary>
+		XInput = 8,
+
+		/// <summary>
+		///     macOS HIDManager devices.
+		/// </summary>
+		Hidm = 16
+	}
+}
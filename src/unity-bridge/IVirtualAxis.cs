@@ -47,6 +47,10 @@ namespace RavingBots.MultiInput
 		///     and isn't in this one.
 		/// </summary>
 		/// <value>If <c>true</c>, this axis has returned to the rest state in the current frame.</value>
+		/// <remarks>
+		///     Buttons and keys on devices also report <c>true</c> if they were released at any point
+		///     during the last frame, even if they were pressed again before it ended.
+		/// </remarks>
 		bool IsUp { get; }
 
 		/// <summary>
@@ -54,6 +58,10 @@ namespace RavingBots.MultiInput
 		///     but isn't in this one.
 		/// </summary>
 		/// <value>If <c>true</c>, this axis has left rest state in the current frame.</value>
+		/// <remarks>
+		///     Buttons and keys on devices also report <c>true</c> if they were pressed at any point
+		///     during the last frame, even if they were released again before it ended.
+		/// </remarks>
 		bool IsDown { get; }
 
 		/// <summary>
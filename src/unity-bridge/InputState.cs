@@ -56,6 +56,8 @@ namespace RavingBots.MultiInput
 		private Native.DeviceCallback _deviceCallback;
 		private Dictionary<long, NativeDevice> _devices;
 		private bool _ready;
+		private int _sliceFrame = -1;
+		private float _sliceRealtime;
 
 		/// <summary>
 		///     Preferred log level.
@@ -67,6 +69,13 @@ namespace RavingBots.MultiInput
 		/// </summary>
 		public bool UseFixedUpdate;
 
+		/// <summary>
+		///     With <see cref="UseFixedUpdate" />, splits the events of each rendered frame by their
+		///     timestamps so every fixed step sees only the input from its own interval, instead of
+		///     all steps of the frame seeing the same state.
+		/// </summary>
+		public bool SliceFixedSteps;
+
 		/// <summary>
 		///     Toggles lifetime management. If <c>true</c>, <c>DontDestroyOnLoad</c> will be called on
 		///     GameObject containing this component and extraneous instances will be automatically
@@ -154,7 +163,23 @@ namespace RavingBots.MultiInput
 				return;
 			}
 
-			DoUpdate();
+			if (!SliceFixedSteps)
+			{
+				DoUpdate();
+				return;
+			}
+
+			if (_sliceFrame != Time.frameCount)
+			{
+				_sliceFrame = Time.frameCount;
+				Native.DrainSlices(_context, 0, 0, EstimateFixedSteps());
+			}
+
+			// more steps than estimated, the extra ones drain normally
+			if (!Native.CommitSlice(_context))
+			{
+				DoUpdate();
+			}
 		}
 
 		[UsedImplicitly]
@@ -236,6 +261,18 @@ namespace RavingBots.MultiInput
 			Native.DrainEvents(_context);
 		}
 
+		private int EstimateFixedSteps()
+		{
+			// the number of fixed steps Unity runs this frame isn't known up front,
+			// slices left over are committed with the next frame's events
+			var now = Time.realtimeSinceStartup;
+			var elapsed = (now - _sliceRealtime) * Time.timeScale;
+			_sliceRealtime = now;
+
+			var maxSteps = Mathf.Max(1, Mathf.CeilToInt(Time.maximumDeltaTime / Time.fixedDeltaTime));
+			return Mathf.Clamp(Mathf.RoundToInt(elapsed / Time.fixedDeltaTime), 1, maxSteps);
+		}
+
 		[CanBeNull]
 		internal NativeDevice GetDevice(long id)
 		{
@@ -37,6 +37,98 @@ namespace RavingBots.MultiInput
 			public uint AxisCount;
 		}
 
+		[StructLayout(LayoutKind.Sequential)]
+		[SuppressMessage("ReSharper", "FieldCanBeMadeReadOnly.Global")]
+		[SuppressMessage("ReSharper", "MemberCanBePrivate.Global")]
+		public struct HapticsKeyframe
+		{
+			public int Time;
+			public float Left;
+			public float Right;
+		}
+
+		[StructLayout(LayoutKind.Sequential)]
+		[SuppressMessage("ReSharper", "FieldCanBeMadeReadOnly.Global")]
+		[SuppressMessage("ReSharper", "MemberCanBePrivate.Global")]
+		public struct PatternStep
+		{
+			public InputCode Code;
+			public int Window;
+		}
+
+		[StructLayout(LayoutKind.Sequential)]
+		[SuppressMessage("ReSharper", "FieldCanBeMadeReadOnly.Global")]
+		[SuppressMessage("ReSharper", "MemberCanBePrivate.Global")]
+		public struct PatternMatch
+		{
+			public int Pattern;
+			public long Device;
+		}
+
+		[StructLayout(LayoutKind.Sequential)]
+		[SuppressMessage("ReSharper", "FieldCanBeMadeReadOnly.Global")]
+		[SuppressMessage("ReSharper", "MemberCanBePrivate.Global")]
+		public struct ActionBinding
+		{
+			public int Player;
+			public int Action;
+			public long Device;
+			public InputCode Code;
+			public InputCode FirstModifier;
+			public InputCode SecondModifier;
+			public float PressThreshold;
+			public float ReleaseThreshold;
+			public float Scale;
+		}
+
+		public const int LatencyBucketCount = 20;
+
+		[StructLayout(LayoutKind.Sequential)]
+		[SuppressMessage("ReSharper", "FieldCanBeMadeReadOnly.Global")]
+		[SuppressMessage("ReSharper", "MemberCanBePrivate.Global")]
+		public struct LatencyStats
+		{
+			public ulong SampleCount;
+			[MarshalAs(UnmanagedType.ByValArray, SizeConst = LatencyBucketCount)]
+			public ulong[] Buckets;
+			public float LatencyMin;
+			public float LatencyMax;
+			public float LatencyMean;
+
+			public ulong ReportCount;
+			public float ReportRate;
+			public float IntervalMean;
+			public float Jitter;
+
+			public ulong OverflowCount;
+			public ulong ResyncCount;
+		}
+
+		// Name, Serial and Codes must stay pinned for the duration of the call
+		[StructLayout(LayoutKind.Sequential)]
+		[SuppressMessage("ReSharper", "FieldCanBeMadeReadOnly.Global")]
+		[SuppressMessage("ReSharper", "MemberCanBePrivate.Global")]
+		public struct VirtualDeviceDesc
+		{
+			public IntPtr Name;
+			public IntPtr Serial;
+			public int VendorId;
+			public int ProductId;
+			public int Revision;
+			public IntPtr Codes;
+			public UIntPtr CodeCount;
+		}
+
+		[StructLayout(LayoutKind.Sequential)]
+		[SuppressMessage("ReSharper", "FieldCanBeMadeReadOnly.Global")]
+		[SuppressMessage("ReSharper", "MemberCanBePrivate.Global")]
+		public struct VirtualEvent
+		{
+			public InputCode Code;
+			public float Value;
+			public ulong Time;
+		}
+
 		[UnmanagedFunctionPointer(CallingConvention.StdCall)]
 		public delegate void LogCallback(IntPtr userData, LogLevel level, IntPtr message);
 
@@ -52,6 +144,12 @@ namespace RavingBots.MultiInput
 		[UnmanagedFunctionPointer(CallingConvention.StdCall)]
 		public delegate void DeviceCallback(IntPtr userData, DeviceEvent @event, long id, ref ApiDevice device);
 
+		[UnmanagedFunctionPointer(CallingConvention.StdCall)]
+		public delegate IntPtr AllocCallback(IntPtr userData, UIntPtr size, UIntPtr alignment);
+
+		[UnmanagedFunctionPointer(CallingConvention.StdCall)]
+		public delegate void FreeCallback(IntPtr userData, IntPtr ptr, UIntPtr size);
+
 		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_create_options")]
 		public static extern IntPtr CreateOptions();
 
@@ -75,6 +173,34 @@ namespace RavingBots.MultiInput
 			[MarshalAs(UnmanagedType.FunctionPtr)] IntPtr callback,
 			IntPtr userData);
 
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_set_allocator")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool SetAllocator(
+			IntPtr options,
+			[MarshalAs(UnmanagedType.FunctionPtr)] IntPtr alloc,
+			[MarshalAs(UnmanagedType.FunctionPtr)] IntPtr free,
+			IntPtr userData);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_set_sources")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool SetSources(IntPtr options, SourceKind sources);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_set_device_classes")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool SetDeviceClasses(IntPtr options, DeviceClass classes);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_set_lazy_sources")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool SetLazySources(IntPtr options, [MarshalAs(UnmanagedType.Bool)] bool lazy);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_set_shared_sources")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool SetSharedSources(IntPtr options, [MarshalAs(UnmanagedType.Bool)] bool shared);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_set_drain_budget")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool SetDrainBudget(IntPtr options, int maxEvents, int maxMicroseconds);
+
 		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_destroy_options")]
 		[return: MarshalAs(UnmanagedType.Bool)]
 		public static extern bool DestroyOptions(IntPtr options);
@@ -90,10 +216,34 @@ namespace RavingBots.MultiInput
 		[return: MarshalAs(UnmanagedType.Bool)]
 		public static extern bool Reset(IntPtr context);
 
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_open_sources")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool OpenSources(IntPtr context, DeviceClass classes);
+
 		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_drain_events")]
 		[return: MarshalAs(UnmanagedType.Bool)]
 		public static extern bool DrainEvents(IntPtr context);
 
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_drain_devices")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool DrainDevices(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 2)]
+			long[] ids,
+			[MarshalAs(UnmanagedType.SysUInt)] uint count);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_drain_slices")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool DrainSlices(IntPtr context, ulong start, ulong end, int count);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_commit_slice")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool CommitSlice(IntPtr context);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_wait_events")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool WaitEvents(IntPtr context, int timeout);
+
 		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_get_devices")]
 		public static extern IntPtr GetDevices(IntPtr context);
 
@@ -134,6 +284,21 @@ namespace RavingBots.MultiInput
 			float left,
 			float right);
 
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_play_haptics")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool PlayHaptics(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.I8)] long id,
+			[MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]
+			HapticsKeyframe[] keyframes,
+			[MarshalAs(UnmanagedType.SysUInt)] uint count);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_stop_haptics")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool StopHaptics(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.I8)] long id);
+
 		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_reset_device")]
 		[return: MarshalAs(UnmanagedType.Bool)]
 		public static extern bool ResetDevice(
@@ -180,6 +345,14 @@ namespace RavingBots.MultiInput
 			[MarshalAs(UnmanagedType.I8)] long id,
 			InputCode code);
 
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_get_changed_time")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool GetChangedTime(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.I8)] long id,
+			InputCode code,
+			out ulong time);
+
 		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_set_value")]
 		[return: MarshalAs(UnmanagedType.Bool)]
 		public static extern bool SetValue(
@@ -214,6 +387,206 @@ namespace RavingBots.MultiInput
 			[MarshalAs(UnmanagedType.I8)] ref long outId,
 			ref InputCode outCode);
 
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_any_held")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool AnyHeld(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.I8)] long id);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_all_held")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool AllHeld(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.I8)] long id,
+			[MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]
+			InputCode[] codes,
+			[MarshalAs(UnmanagedType.SysUInt)] uint count);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_get_pressed")]
+		[return: MarshalAs(UnmanagedType.SysUInt)]
+		public static extern uint GetPressed(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.I8)] long id,
+			[CanBeNull] [MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]
+			InputCode[] buffer,
+			[MarshalAs(UnmanagedType.SysUInt)] uint size);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_get_released")]
+		[return: MarshalAs(UnmanagedType.SysUInt)]
+		public static extern uint GetReleased(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.I8)] long id,
+			[CanBeNull] [MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]
+			InputCode[] buffer,
+			[MarshalAs(UnmanagedType.SysUInt)] uint size);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_get_transitions")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool GetTransitions(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.I8)] long id,
+			[MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]
+			InputCode[] codes,
+			[MarshalAs(UnmanagedType.SysUInt)] uint count,
+			[CanBeNull] [MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)] [Out]
+			int[] presses,
+			[CanBeNull] [MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)] [Out]
+			int[] releases);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_add_pattern")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool AddPattern(
+			IntPtr context,
+			PatternKind kind,
+			[MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]
+			PatternStep[] steps,
+			[MarshalAs(UnmanagedType.SysUInt)] uint count,
+			out int id);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_remove_pattern")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool RemovePattern(
+			IntPtr context,
+			int id);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_get_matches")]
+		[return: MarshalAs(UnmanagedType.SysUInt)]
+		public static extern uint GetMatches(
+			IntPtr context,
+			[CanBeNull] [MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 2)] [Out]
+			PatternMatch[] buffer,
+			[MarshalAs(UnmanagedType.SysUInt)] uint size);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_set_bindings")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool SetBindings(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.SysUInt)] uint playerCount,
+			[MarshalAs(UnmanagedType.SysUInt)] uint actionCount,
+			[CanBeNull] [MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 4)]
+			ActionBinding[] bindings,
+			[MarshalAs(UnmanagedType.SysUInt)] uint count);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_evaluate_actions")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool EvaluateActions(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 2)] [Out]
+			float[] values,
+			[MarshalAs(UnmanagedType.SysUInt)] uint size);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_get_latency")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool GetLatency(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.I8)] long id,
+			out LatencyStats stats);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_reset_latency")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool ResetLatency(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.I8)] long id);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_create_encoder")]
+		public static extern IntPtr CreateEncoder(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.I8)] long id,
+			int precision);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_encode_frame")]
+		[return: MarshalAs(UnmanagedType.SysUInt)]
+		public static extern uint EncodeFrame(
+			IntPtr context,
+			IntPtr encoder,
+			[Out] [MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]
+			byte[] buffer,
+			[MarshalAs(UnmanagedType.SysUInt)] uint size,
+			out int sequence);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_ack_frame")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool AckFrame(IntPtr context, IntPtr encoder, int sequence);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_destroy_encoder")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool DestroyEncoder(IntPtr context, IntPtr encoder);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_create_decoder")]
+		public static extern IntPtr CreateDecoder(IntPtr context, out long mirror);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_decode_frame")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool DecodeFrame(
+			IntPtr context,
+			IntPtr decoder,
+			[MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]
+			byte[] buffer,
+			[MarshalAs(UnmanagedType.SysUInt)] uint size,
+			out int sequence);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_destroy_decoder")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool DestroyDecoder(IntPtr context, IntPtr decoder);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_set_history_capacity")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool SetHistoryCapacity(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.SysUInt)] uint capacity);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_get_history_range")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool GetHistoryRange(IntPtr context, out ulong oldest, out ulong newest);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_get_history_devices")]
+		[return: MarshalAs(UnmanagedType.SysUInt)]
+		public static extern uint GetHistoryDevices(
+			IntPtr context,
+			ulong frame,
+			[CanBeNull] [Out] [MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]
+			long[] buffer,
+			[MarshalAs(UnmanagedType.SysUInt)] uint size);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_get_history_values")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool GetHistoryValues(
+			IntPtr context,
+			ulong frame,
+			[MarshalAs(UnmanagedType.I8)] long id,
+			[MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 4)]
+			InputCode[] codes,
+			[MarshalAs(UnmanagedType.SysUInt)] uint count,
+			[Out] [MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 4)]
+			float[] values);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_create_virtual_device")]
+		[return: MarshalAs(UnmanagedType.I8)]
+		public static extern long CreateVirtualDevice(IntPtr context, ref VirtualDeviceDesc desc);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_inject")]
+		[return: MarshalAs(UnmanagedType.SysUInt)]
+		public static extern uint Inject(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.I8)] long id,
+			[MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]
+			VirtualEvent[] events,
+			[MarshalAs(UnmanagedType.SysUInt)] uint count);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_destroy_virtual_device")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool DestroyVirtualDevice(
+			IntPtr context,
+			[MarshalAs(UnmanagedType.I8)] long id);
+
+		[DllImport(Library, CallingConvention = CallingConvention.StdCall, EntryPoint = "rb_minput_parse_input_code")]
+		[return: MarshalAs(UnmanagedType.Bool)]
+		public static extern bool ParseInputCode(
+			[MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 1)]
+			byte[] name,
+			[MarshalAs(UnmanagedType.SysUInt)] uint length,
+			out InputCode code);
+
 		public static string Decode(IntPtr str)
 		{
 			if (str == IntPtr.Zero)
@@ -11,12 +11,14 @@ namespace RavingBots.MultiInput
 	{
 		private readonly IntPtr _context;
 		private readonly long _device;
+		private readonly InputCode[] _codes;
+		private readonly int[] _transitions = new int[1];
 
-		private bool PreviousHeld => !Mathf.Approximately(PreviousValue, 0);
 		public bool IsHeld => !Mathf.Approximately(Value, 0);
 
-		public bool IsUp => !IsHeld && PreviousHeld;
-		public bool IsDown => IsHeld && !PreviousHeld;
+		// native axes count transitions, so taps shorter than a frame aren't lost
+		public bool IsUp => GetTransitions(false) > 0;
+		public bool IsDown => GetTransitions(true) > 0;
 		public bool HasChanged => !Mathf.Approximately(Value, PreviousValue);
 
 		public float Value => Native.GetValue(_context, _device, Code);
@@ -29,6 +31,23 @@ namespace RavingBots.MultiInput
 			Code = code;
 			_device = device;
 			_context = context;
+			_codes = new[] { code };
+		}
+
+		private int GetTransitions(bool presses)
+		{
+			_transitions[0] = 0;
+
+			if (presses)
+			{
+				Native.GetTransitions(_context, _device, _codes, 1, _transitions, null);
+			}
+			else
+			{
+				Native.GetTransitions(_context, _device, _codes, 1, null, _transitions);
+			}
+
+			return _transitions[0];
 		}
 
 		public void Set(float value)